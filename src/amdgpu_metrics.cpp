@@ -0,0 +1,133 @@
+#include "amdgpu_metrics.h"
+#include <cstring>
+#include <algorithm>
+#include "throttle.h"
+
+// fields the firmware does not fill in are set to all ones
+#define METRIC(v) ((v) == UINT16_MAX ? -1 : int(v))
+
+static_assert(offsetof(struct gpu_metrics_v1_3, indep_throttle_status) == 112, "gpu_metrics_v1_3 layout");
+static_assert(offsetof(struct gpu_metrics_v2_2, indep_throttle_status) == 120, "gpu_metrics_v2_2 layout");
+
+static bool parse_v1(const void *data, size_t size, uint8_t content_revision, struct amdgpu_metrics& m)
+{
+    struct gpu_metrics_v1_1 g;
+    if (size < sizeof(g))
+        return false;
+    memcpy(&g, data, sizeof(g));
+
+    m.load = METRIC(g.average_gfx_activity);
+    m.temp = METRIC(g.temperature_edge);
+    m.core_clock = METRIC(g.current_gfxclk);
+    m.memory_clock = METRIC(g.current_uclk);
+    m.power_usage = METRIC(g.average_socket_power);
+    m.throttle_status = g.throttle_status;
+
+    if (content_revision >= 3 && size >= sizeof(struct gpu_metrics_v1_3)) {
+        struct gpu_metrics_v1_3 g3;
+        memcpy(&g3, data, sizeof(g3));
+        m.indep_throttle_status = g3.indep_throttle_status;
+        m.has_indep_throttle_status = true;
+    }
+    return true;
+}
+
+static bool parse_v2_0(const void *data, size_t size, struct amdgpu_metrics& m)
+{
+    struct gpu_metrics_v2_0 g;
+    if (size < sizeof(g))
+        return false;
+    memcpy(&g, data, sizeof(g));
+
+    m.load = METRIC(g.average_gfx_activity);
+    if (m.load >= 0)
+        m.load /= 100;
+    m.temp = METRIC(g.temperature_gfx);
+    if (m.temp >= 0)
+        m.temp /= 100;
+    m.core_clock = METRIC(g.current_gfxclk);
+    m.memory_clock = METRIC(g.current_uclk);
+    m.power_usage = METRIC(g.average_socket_power);
+    if (m.power_usage >= 0)
+        m.power_usage /= 1000;
+    m.throttle_status = g.throttle_status;
+    return true;
+}
+
+// v2_1 is v2_2 without the trailing indep_throttle_status
+static bool parse_v2(const void *data, size_t size, uint8_t content_revision, struct amdgpu_metrics& m)
+{
+    if (content_revision == 0)
+        return parse_v2_0(data, size, m);
+
+    struct gpu_metrics_v2_2 g {};
+    if (size < offsetof(struct gpu_metrics_v2_2, indep_throttle_status))
+        return false;
+    memcpy(&g, data, std::min(size, sizeof(g)));
+
+    m.load = METRIC(g.average_gfx_activity);
+    if (m.load >= 0)
+        m.load /= 100;
+    m.temp = METRIC(g.temperature_gfx);
+    if (m.temp >= 0)
+        m.temp /= 100;
+    m.core_clock = METRIC(g.current_gfxclk);
+    m.memory_clock = METRIC(g.current_uclk);
+    m.power_usage = METRIC(g.average_socket_power);
+    if (m.power_usage >= 0)
+        m.power_usage /= 1000;
+    m.throttle_status = g.throttle_status;
+    if (content_revision >= 2 && size >= sizeof(g)) {
+        m.indep_throttle_status = g.indep_throttle_status;
+        m.has_indep_throttle_status = true;
+    }
+    return true;
+}
+
+bool amdgpu_parse_metrics(const void *data, size_t size, struct amdgpu_metrics& metrics)
+{
+    struct metrics_table_header header;
+    if (size < sizeof(header))
+        return false;
+    memcpy(&header, data, sizeof(header));
+
+    // a short read would leave the tail of the struct stale
+    if (header.structure_size > size)
+        return false;
+    size = header.structure_size;
+
+    metrics = {};
+    switch (header.format_revision) {
+        case 1:
+            // v1_0 has a different layout and only shipped briefly for
+            // Arcturus, v1_4 and later reorder everything for MI300
+            if (header.content_revision < 1 || header.content_revision > 3)
+                return false;
+            return parse_v1(data, size, header.content_revision, metrics);
+        case 2:
+            return parse_v2(data, size, header.content_revision, metrics);
+        default:
+            return false;
+    }
+}
+
+/* SMU_THROTTLER_* bit ranges of indep_throttle_status, from amdgpu_smu.h:
+ * 0-15 power limits, 16-31 current limits, 32-55 temperatures, 56-63 other.
+ * The older throttle_status bits mean something else on every ASIC. */
+unsigned amdgpu_throttle_reasons(const struct amdgpu_metrics& metrics)
+{
+    if (!metrics.has_indep_throttle_status)
+        return metrics.throttle_status ? THROTTLE_OTHER : 0;
+
+    uint64_t s = metrics.indep_throttle_status;
+    unsigned reasons = 0;
+    if (s & 0xffffull)
+        reasons |= THROTTLE_POWER;
+    if (s & 0xffff0000ull)
+        reasons |= THROTTLE_CURRENT;
+    if (s & 0x00ffffff00000000ull)
+        reasons |= THROTTLE_THERMAL;
+    if (s & 0xff00000000000000ull)
+        reasons |= THROTTLE_OTHER;
+    return reasons;
+}
@@ -0,0 +1,237 @@
+#pragma once
+#ifndef MANGOHUD_AMDGPU_METRICS_H
+#define MANGOHUD_AMDGPU_METRICS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Layouts of /sys/class/drm/cardN/device/gpu_metrics as defined by the kernel
+ * in drivers/gpu/drm/amd/include/kgd_pp_interface.h. v1_2 and v1_3 append
+ * fields to v1_1, v2_2 and later append to v2_1. v1_0, v2_0 and v1_4 onwards
+ * (MI300) have layouts of their own, of those only v2_0 is parsed. */
+
+struct metrics_table_header {
+    uint16_t structure_size;
+    uint8_t  format_revision;
+    uint8_t  content_revision;
+};
+
+// dGPUs, gpu_metrics_v1_1 and later
+struct gpu_metrics_v1_1 {
+    struct metrics_table_header common_header;
+
+    // temperature, C
+    uint16_t temperature_edge;
+    uint16_t temperature_hotspot;
+    uint16_t temperature_mem;
+    uint16_t temperature_vrgfx;
+    uint16_t temperature_vrsoc;
+    uint16_t temperature_vrmem;
+
+    // utilization, %
+    uint16_t average_gfx_activity;
+    uint16_t average_umc_activity;
+    uint16_t average_mm_activity;
+
+    // power, W
+    uint16_t average_socket_power;
+    uint64_t energy_accumulator;
+
+    // driver attached timestamp, ns
+    uint64_t system_clock_counter;
+
+    // average clocks, MHz
+    uint16_t average_gfxclk_frequency;
+    uint16_t average_socclk_frequency;
+    uint16_t average_uclk_frequency;
+    uint16_t average_vclk0_frequency;
+    uint16_t average_dclk0_frequency;
+    uint16_t average_vclk1_frequency;
+    uint16_t average_dclk1_frequency;
+
+    // current clocks, MHz
+    uint16_t current_gfxclk;
+    uint16_t current_socclk;
+    uint16_t current_uclk;
+    uint16_t current_vclk0;
+    uint16_t current_dclk0;
+    uint16_t current_vclk1;
+    uint16_t current_dclk1;
+
+    uint32_t throttle_status;
+    uint16_t current_fan_speed;
+};
+
+// gpu_metrics_v1_3 adds a throttle status that is the same on every ASIC
+struct gpu_metrics_v1_3 {
+    struct metrics_table_header common_header;
+
+    uint16_t temperature_edge;
+    uint16_t temperature_hotspot;
+    uint16_t temperature_mem;
+    uint16_t temperature_vrgfx;
+    uint16_t temperature_vrsoc;
+    uint16_t temperature_vrmem;
+
+    uint16_t average_gfx_activity;
+    uint16_t average_umc_activity;
+    uint16_t average_mm_activity;
+
+    uint16_t average_socket_power;
+    uint64_t energy_accumulator;
+
+    uint64_t system_clock_counter;
+
+    uint16_t average_gfxclk_frequency;
+    uint16_t average_socclk_frequency;
+    uint16_t average_uclk_frequency;
+    uint16_t average_vclk0_frequency;
+    uint16_t average_dclk0_frequency;
+    uint16_t average_vclk1_frequency;
+    uint16_t average_dclk1_frequency;
+
+    uint16_t current_gfxclk;
+    uint16_t current_socclk;
+    uint16_t current_uclk;
+    uint16_t current_vclk0;
+    uint16_t current_dclk0;
+    uint16_t current_vclk1;
+    uint16_t current_dclk1;
+
+    uint32_t throttle_status;
+    uint16_t current_fan_speed;
+
+    uint16_t pcie_link_width;
+    uint16_t pcie_link_speed;
+    uint16_t padding;
+    uint32_t gfx_activity_acc;
+    uint32_t mem_activity_acc;
+    uint16_t temperature_hbm[4];
+
+    // v1_2
+    uint64_t firmware_timestamp;
+
+    // v1_3, voltages in mV
+    uint16_t voltage_soc;
+    uint16_t voltage_gfx;
+    uint16_t voltage_mem;
+    uint16_t padding1;
+    uint64_t indep_throttle_status;
+};
+
+// APUs, gpu_metrics_v2_0 only
+struct gpu_metrics_v2_0 {
+    struct metrics_table_header common_header;
+
+    // driver attached timestamp, ns
+    uint64_t system_clock_counter;
+
+    // temperature, centi-C
+    uint16_t temperature_gfx;
+    uint16_t temperature_soc;
+    uint16_t temperature_core[8];
+    uint16_t temperature_l3[2];
+
+    // utilization, centi-%
+    uint16_t average_gfx_activity;
+    uint16_t average_mm_activity;
+
+    // power, mW
+    uint16_t average_socket_power;
+    uint16_t average_cpu_power;
+    uint16_t average_soc_power;
+    uint16_t average_gfx_power;
+    uint16_t average_core_power[8];
+
+    // average clocks, MHz
+    uint16_t average_gfxclk_frequency;
+    uint16_t average_socclk_frequency;
+    uint16_t average_uclk_frequency;
+    uint16_t average_fclk_frequency;
+    uint16_t average_vclk_frequency;
+    uint16_t average_dclk_frequency;
+
+    // current clocks, MHz
+    uint16_t current_gfxclk;
+    uint16_t current_socclk;
+    uint16_t current_uclk;
+    uint16_t current_fclk;
+    uint16_t current_vclk;
+    uint16_t current_dclk;
+    uint16_t current_coreclk[8];
+    uint16_t current_l3clk[2];
+
+    uint32_t throttle_status;
+    uint16_t fan_pwm;
+};
+
+// APUs, gpu_metrics_v2_1 moved the timestamp after the utilization, v2_2
+// appended the ASIC independent throttle status
+struct gpu_metrics_v2_2 {
+    struct metrics_table_header common_header;
+
+    // temperature, centi-C
+    uint16_t temperature_gfx;
+    uint16_t temperature_soc;
+    uint16_t temperature_core[8];
+    uint16_t temperature_l3[2];
+
+    // utilization, centi-%
+    uint16_t average_gfx_activity;
+    uint16_t average_mm_activity;
+
+    // driver attached timestamp, ns
+    uint64_t system_clock_counter;
+
+    // power, mW
+    uint16_t average_socket_power;
+    uint16_t average_cpu_power;
+    uint16_t average_soc_power;
+    uint16_t average_gfx_power;
+    uint16_t average_core_power[8];
+
+    // average clocks, MHz
+    uint16_t average_gfxclk_frequency;
+    uint16_t average_socclk_frequency;
+    uint16_t average_uclk_frequency;
+    uint16_t average_fclk_frequency;
+    uint16_t average_vclk_frequency;
+    uint16_t average_dclk_frequency;
+
+    // current clocks, MHz
+    uint16_t current_gfxclk;
+    uint16_t current_socclk;
+    uint16_t current_uclk;
+    uint16_t current_fclk;
+    uint16_t current_vclk;
+    uint16_t current_dclk;
+    uint16_t current_coreclk[8];
+    uint16_t current_l3clk[2];
+
+    uint32_t throttle_status;
+    uint16_t fan_pwm;
+    uint16_t padding[3];
+
+    // v2_2
+    uint64_t indep_throttle_status;
+};
+
+// Values decoded from a gpu_metrics blob, -1 when the firmware does not report them
+struct amdgpu_metrics {
+    int load = -1;          // %
+    int temp = -1;          // C
+    int core_clock = -1;    // MHz
+    int memory_clock = -1;  // MHz
+    int power_usage = -1;   // W
+    uint32_t throttle_status = 0;        // ASIC specific bits
+    uint64_t indep_throttle_status = 0;  // SMU_THROTTLER_* bits
+    bool has_indep_throttle_status = false;
+};
+
+// THROTTLE_* reasons of decoded metrics
+unsigned amdgpu_throttle_reasons(const struct amdgpu_metrics& metrics);
+
+// Parses a gpu_metrics blob, false for unknown or truncated formats
+bool amdgpu_parse_metrics(const void *data, size_t size, struct amdgpu_metrics& metrics);
+
+#endif //MANGOHUD_AMDGPU_METRICS_H
@@ -7,9 +7,10 @@
 #include <dirent.h>
 #include <string.h>
 #include <algorithm>
-#include <regex>
 #include <inttypes.h>
 #include "string_utils.h"
+#include "io_uring_reader.h"
+#include "sensors.h"
 
 #ifndef PROCDIR
 #define PROCDIR "/proc"
@@ -101,8 +102,6 @@ CPUStats::CPUStats()
 
 CPUStats::~CPUStats()
 {
-    if (m_cpuTempFile)
-        fclose(m_cpuTempFile);
 }
 
 bool CPUStats::Init()
@@ -113,6 +112,7 @@ bool CPUStats::Init()
     std::string line;
     std::ifstream file (PROCSTATFILE);
     bool first = true;
+    size_t cpus = 0;
     m_cpuData.clear();
 
     if (!file.is_open()) {
@@ -130,10 +130,11 @@ bool CPUStats::Init()
                 continue;
             }
 
-            CPUData cpu = {};
-            cpu.totalTime = 1;
-            cpu.totalPeriod = 1;
-            m_cpuData.push_back(cpu);
+            // only online CPUs are listed, ids can have holes
+            const char *p = line.c_str() + 3;
+            unsigned long long cpuid;
+            if (parse_ull(p, cpuid))
+                cpus = std::max<size_t>(cpus, cpuid + 1);
 
         } else if (starts_with(line, "btime ")) {
 
@@ -149,6 +150,23 @@ bool CPUStats::Init()
         }
     } while(true);
 
+    // indexed by CPU number, offline CPUs stay at 0
+    CPUData cpu = {};
+    cpu.totalTime = 1;
+    cpu.totalPeriod = 1;
+    m_cpuData.assign(cpus, cpu);
+    if (m_cpuData.empty()) {
+        std::cerr << "No CPUs in " << PROCSTATFILE << std::endl;
+        return false;
+    }
+
+    // "cpuN " plus ten 20 digit columns per line, the rest of the file is
+    // skipped. Room for every possible CPU, some may come online later.
+    if (m_procStat.add(PROCSTATFILE, (m_cpuData.size() + 1) * 256) < 0) {
+        std::cerr << "Failed to opening " << PROCSTATFILE << std::endl;
+        return false;
+    }
+
     m_inited = true;
     return UpdateCPUData();
 }
@@ -156,181 +174,255 @@ bool CPUStats::Init()
 //TODO take sampling interval into account?
 bool CPUStats::UpdateCPUData()
 {
-    unsigned long long int usertime, nicetime, systemtime, idletime;
-    unsigned long long int ioWait, irq, softIrq, steal, guest, guestnice;
-    int cpuid = -1;
+    // user nice system idle iowait irq softirq steal guest guest_nice
+    unsigned long long int t[10];
+    bool ret = false;
 
     if (!m_inited)
         return false;
 
-    std::string line;
-    std::ifstream file (PROCSTATFILE);
-    bool ret = false;
-
-    if (!file.is_open()) {
-        std::cerr << "Failed to opening " << PROCSTATFILE << std::endl;
+    if (!m_procStat.update()) {
+        std::cerr << "Failed to read " << PROCSTATFILE << std::endl;
         return false;
     }
 
-    do {
-        if (!std::getline(file, line)) {
+    const char *p = m_procStat.text(0);
+    while (p[0] == 'c' && p[1] == 'p' && p[2] == 'u') {
+        // a line cut off by the end of the buffer would parse as smaller times
+        if (!strchr(p, '\n')) {
+            static bool warned = false;
+            if (!warned)
+                std::cerr << PROCSTATFILE << " does not fit the read buffer, skipping the last CPUs" << std::endl;
+            warned = true;
             break;
-        } else if (!ret && sscanf(line.c_str(), "cpu  %16llu %16llu %16llu %16llu %16llu %16llu %16llu %16llu %16llu %16llu",
-            &usertime, &nicetime, &systemtime, &idletime, &ioWait, &irq, &softIrq, &steal, &guest, &guestnice) == 10) {
-            ret = true;
-            calculateCPUData(m_cpuDataTotal, usertime, nicetime, systemtime, idletime, ioWait, irq, softIrq, steal, guest, guestnice);
-        } else if (sscanf(line.c_str(), "cpu%4d %16llu %16llu %16llu %16llu %16llu %16llu %16llu %16llu %16llu %16llu",
-            &cpuid, &usertime, &nicetime, &systemtime, &idletime, &ioWait, &irq, &softIrq, &steal, &guest, &guestnice) == 11) {
-
-            //std::cerr << "Parsing 'cpu" << cpuid << "' line:" <<  line << std::endl;
+        }
+        p += 3;
 
+        CPUData *cpuData = &m_cpuDataTotal;
+        if (*p != ' ') {
+            unsigned long long int cpuid = 0;
             if (!ret) {
-                //std::cerr << "Failed to parse 'cpu' line" << std::endl;
-                std::cerr << "Failed to parse 'cpu' line:" <<  line << std::endl;
+                std::cerr << "Failed to parse 'cpu' line" << std::endl;
                 return false;
             }
 
-            if (cpuid < 0 /* can it? */ || (size_t)cpuid > m_cpuData.size()) {
-                std::cerr << "Cpu id '" << cpuid << "' is out of bounds" << std::endl;
-                return false;
+            // came online after Init()
+            if (!parse_ull(p, cpuid) || cpuid >= m_cpuData.size()) {
+                skip_line(p);
+                continue;
             }
+            cpuData = &m_cpuData[cpuid];
+        }
 
-            CPUData& cpuData = m_cpuData[cpuid];
-            calculateCPUData(cpuData, usertime, nicetime, systemtime, idletime, ioWait, irq, softIrq, steal, guest, guestnice);
-            cpuid = -1;
-
-        } else {
+        // older kernels lack the trailing steal/guest columns
+        size_t n = 0;
+        for (; n < 10 && parse_ull(p, t[n]); n++);
+        if (n < 4)
             break;
-        }
-    } while(true);
+        for (; n < 10; n++)
+            t[n] = 0;
+
+        calculateCPUData(*cpuData, t[0], t[1], t[2], t[3], t[4], t[5], t[6], t[7], t[8], t[9]);
+        ret = true;
+        skip_line(p);
+    }
 
     m_cpuPeriod = (double)m_cpuData[0].totalPeriod / m_cpuData.size();
     m_updatedCPUs = true;
     return ret;
 }
 
-bool CPUStats::UpdateCoreMhz() {
-    m_coreMhz.clear();
+// Only online CPUs are listed, each under its "processor : N" line
+static bool update_core_mhz_cpuinfo(std::vector<CPUData>& cpuData)
+{
     std::ifstream cpuInfo(PROCCPUINFOFILE);
     std::string row;
-    size_t i = 0;
-    while (std::getline(cpuInfo, row) && i < m_cpuData.size()) {
-        if (row.find("MHz") != std::string::npos){
-            row = std::regex_replace(row, std::regex(R"([^0-9.])"), "");
-            if (!try_stoi(m_cpuData[i].mhz, row))
-                m_cpuData[i].mhz = 0;
-            i++;
+    size_t cpu = cpuData.size();
+    bool found = false;
+
+    for (auto& data : cpuData)
+        data.mhz = 0;
+    while (std::getline(cpuInfo, row)) {
+        auto colon = row.find(':');
+        if (colon == std::string::npos)
+            continue;
+        if (starts_with(row, "processor")) {
+            char *end;
+            cpu = strtoul(row.c_str() + colon + 1, &end, 10);
+            if (end == row.c_str() + colon + 1)
+                cpu = cpuData.size();
+        } else if (starts_with(row, "cpu MHz") && cpu < cpuData.size()) {
+            cpuData[cpu].mhz = atoi(row.c_str() + colon + 1);
+            found = true;
         }
     }
-    m_cpuDataTotal.cpu_mhz = 0;
-    for (auto data : m_cpuData)
-        m_cpuDataTotal.cpu_mhz += data.mhz;
-    m_cpuDataTotal.cpu_mhz /= m_cpuData.size();
+    return found;
+}
+
+void CPUStats::InitCoreMhz() {
+    if (m_cpuFreqInited)
+        return;
+
+    m_cpuFreqInited = true;
+    bool found = false;
+    m_cpuFreqIdx.resize(m_cpuData.size());
+    for (size_t i = 0; i < m_cpuFreqIdx.size(); i++) {
+        std::string path = "/sys/devices/system/cpu/cpu" + std::to_string(i) + "/cpufreq/scaling_cur_freq";
+        m_cpuFreqIdx[i] = m_cpuFreq.add(path);
+        found |= (m_cpuFreqIdx[i] >= 0);
+    }
+    if (!found) {
+#ifndef NDEBUG
+        std::cerr << "cpufreq: scaling_cur_freq not available, using " PROCCPUINFOFILE << std::endl;
+#endif
+        m_cpuFreqIdx.clear();
+    }
+}
+
+bool CPUStats::UpdateCoreMhz() {
+    InitCoreMhz();
+
+    if (m_cpuFreqIdx.empty()) {
+        update_core_mhz_cpuinfo(m_cpuData);
+    } else {
+        m_cpuFreq.update();
+        for (size_t i = 0; i < m_cpuFreqIdx.size(); i++) {
+            int64_t khz = 0;
+            if (!m_cpuFreq.get(m_cpuFreqIdx[i], khz))
+                khz = 0;
+            m_cpuData[i].mhz = khz / 1000;
+        }
+    }
+
+    // of the online CPUs
+    int sum = 0, online = 0;
+    for (auto& data : m_cpuData) {
+        if (data.mhz > 0) {
+            sum += data.mhz;
+            online++;
+        }
+    }
+    m_cpuDataTotal.cpu_mhz = online ? sum / online : 0;
     return true;
 }
 
 bool CPUStats::UpdateCpuTemp() {
-    if (!m_cpuTempFile)
+    if (m_cpuTemp.empty())
         return false;
 
-    int temp = 0;
-    rewind(m_cpuTempFile);
-    fflush(m_cpuTempFile);
-    bool ret = (fscanf(m_cpuTempFile, "%d", &temp) == 1);
+    int64_t temp = 0;
+    m_cpuTemp.update();
+    bool ret = m_cpuTemp.get(0, temp);
     m_cpuDataTotal.temp = temp / 1000;
 
     return ret;
 }
 
-static bool get_cpu_power_k10temp(CPUPowerData* cpuPowerData, int& power) {
+static bool get_cpu_power_k10temp(CPUPowerData* cpuPowerData, float& power) {
     CPUPowerData_k10temp* powerData_k10temp = (CPUPowerData_k10temp*)cpuPowerData;
+    auto& counters = powerData_k10temp->counters;
 
-    if (!powerData_k10temp->coreVoltageFile || !powerData_k10temp->coreCurrentFile || !powerData_k10temp->socVoltageFile || !powerData_k10temp->socCurrentFile)
+    if (!counters.valid(powerData_k10temp->coreVoltage) || !counters.valid(powerData_k10temp->coreCurrent)
+        || !counters.valid(powerData_k10temp->socVoltage) || !counters.valid(powerData_k10temp->socCurrent))
         return false;
 
-    rewind(powerData_k10temp->coreVoltageFile);
-    rewind(powerData_k10temp->coreCurrentFile);
-    rewind(powerData_k10temp->socVoltageFile);
-    rewind(powerData_k10temp->socCurrentFile);
-
-    fflush(powerData_k10temp->coreVoltageFile);
-    fflush(powerData_k10temp->coreCurrentFile);
-    fflush(powerData_k10temp->socVoltageFile);
-    fflush(powerData_k10temp->socCurrentFile);
+    counters.update();
 
-    int coreVoltage, coreCurrent;
-    int socVoltage, socCurrent;
+    int64_t coreVoltage, coreCurrent;
+    int64_t socVoltage, socCurrent;
 
-    if (fscanf(powerData_k10temp->coreVoltageFile, "%d", &coreVoltage) != 1)
+    if (!counters.get(powerData_k10temp->coreVoltage, coreVoltage))
         return false;
-    if (fscanf(powerData_k10temp->coreCurrentFile, "%d", &coreCurrent) != 1)
+    if (!counters.get(powerData_k10temp->coreCurrent, coreCurrent))
         return false;
-    if (fscanf(powerData_k10temp->socVoltageFile, "%d", &socVoltage) != 1)
+    if (!counters.get(powerData_k10temp->socVoltage, socVoltage))
         return false;
-    if (fscanf(powerData_k10temp->socCurrentFile, "%d", &socCurrent) != 1)
+    if (!counters.get(powerData_k10temp->socCurrent, socCurrent))
         return false;
 
-    power = (coreVoltage * coreCurrent + socVoltage * socCurrent) / 1000000;
+    power = (coreVoltage * coreCurrent + socVoltage * socCurrent) / 1000000.f;
 
     return true;
 }
 
-static bool get_cpu_power_zenpower(CPUPowerData* cpuPowerData, int& power) {
+static bool get_cpu_power_zenpower(CPUPowerData* cpuPowerData, float& power) {
     CPUPowerData_zenpower* powerData_zenpower = (CPUPowerData_zenpower*)cpuPowerData;
+    auto& counters = powerData_zenpower->counters;
 
-    if (!powerData_zenpower->corePowerFile || !powerData_zenpower->socPowerFile)
+    if (!counters.valid(powerData_zenpower->corePower) || !counters.valid(powerData_zenpower->socPower))
         return false;
 
-    rewind(powerData_zenpower->corePowerFile);
-    rewind(powerData_zenpower->socPowerFile);
+    counters.update();
 
-    fflush(powerData_zenpower->corePowerFile);
-    fflush(powerData_zenpower->socPowerFile);
+    int64_t corePower, socPower;
 
-    int corePower, socPower;
-
-    if (fscanf(powerData_zenpower->corePowerFile, "%d", &corePower) != 1)
+    if (!counters.get(powerData_zenpower->corePower, corePower))
         return false;
-    if (fscanf(powerData_zenpower->socPowerFile, "%d", &socPower) != 1)
+    if (!counters.get(powerData_zenpower->socPower, socPower))
         return false;
 
-    power = (corePower + socPower) / 1000000;
+    power = (corePower + socPower) / 1000000.f;
 
     return true;
 }
 
-static bool get_cpu_power_rapl(CPUPowerData* cpuPowerData, int& power) {
+static bool get_cpu_power_rapl(CPUPowerData* cpuPowerData, float& power, uint64_t& energy) {
     CPUPowerData_rapl* powerData_rapl = (CPUPowerData_rapl*)cpuPowerData;
+    auto& counters = powerData_rapl->counters;
 
-    if (!powerData_rapl->energyCounterFile)
+    if (powerData_rapl->domains.empty())
         return false;
 
-    rewind(powerData_rapl->energyCounterFile);
-    fflush(powerData_rapl->energyCounterFile);
-
-    uint64_t energyCounterValue = 0;
-    if (fscanf(powerData_rapl->energyCounterFile, "%" SCNu64, &energyCounterValue) != 1)
-        return false;
+    counters.update();
 
     Clock::time_point now = Clock::now();
     Clock::duration timeDiff = now - powerData_rapl->lastCounterValueTime;
     int64_t timeDiffMicro = std::chrono::duration_cast<std::chrono::microseconds>(timeDiff).count();
-    uint64_t energyCounterDiff = energyCounterValue - powerData_rapl->lastCounterValue;
 
-    if (powerData_rapl->lastCounterValue > 0 && energyCounterValue > powerData_rapl->lastCounterValue)
-        power = energyCounterDiff / timeDiffMicro;
+    bool ret = false;
+    power = 0;
+    energy = 0;
+    for (auto& domain : powerData_rapl->domains) {
+        int64_t value = 0;
+        if (!counters.get(domain.energyCounter, value))
+            continue;
+        uint64_t energyCounterValue = value;
+
+        if (domain.hasLastCounterValue) {
+            uint64_t energyCounterDiff;
+            if (energyCounterValue >= domain.lastCounterValue)
+                energyCounterDiff = energyCounterValue - domain.lastCounterValue;
+            else if (domain.maxEnergyRange > domain.lastCounterValue)
+                energyCounterDiff = domain.maxEnergyRange - domain.lastCounterValue + energyCounterValue;
+            else // wrapped without a known range, skip this interval
+                energyCounterDiff = 0;
+
+            domain.energy += energyCounterDiff;
+            if (timeDiffMicro > 0)
+                domain.power = float(energyCounterDiff) / timeDiffMicro;
+        }
+        domain.lastCounterValue = energyCounterValue;
+        domain.hasLastCounterValue = true;
+
+        // subdomains are already part of their package, dram is not
+        if (starts_with(domain.name, "package")) {
+            power += domain.power;
+            energy += domain.energy;
+            ret = true;
+        }
+    }
 
-    powerData_rapl->lastCounterValue = energyCounterValue;
     powerData_rapl->lastCounterValueTime = now;
 
-    return true;
+    return ret;
 }
 
 bool CPUStats::UpdateCpuPower() {
     if(!m_cpuPowerData)
         return false;
 
-    int power = 0;
+    float power = 0;
+    uint64_t energy = 0;
 
     switch(m_cpuPowerData->source) {
         case CPU_POWER_K10TEMP:
@@ -340,171 +432,90 @@ bool CPUStats::UpdateCpuPower() {
             if (!get_cpu_power_zenpower(m_cpuPowerData.get(), power)) return false;
             break;
         case CPU_POWER_RAPL:
-            if (!get_cpu_power_rapl(m_cpuPowerData.get(), power)) return false;
+            if (!get_cpu_power_rapl(m_cpuPowerData.get(), power, energy)) return false;
             break;
         default:
             return false;
     }
 
-    m_cpuDataTotal.power = power;
+    Clock::time_point now = Clock::now();
+    if (m_cpuPowerData->source == CPU_POWER_RAPL) {
+        m_cpuEnergy = energy;
+    } else if (m_cpuPowerTime != Clock::time_point{}) {
+        // hwmon only reports power, integrate it (W * us = uJ)
+        auto timeDiffMicro = std::chrono::duration_cast<std::chrono::microseconds>(now - m_cpuPowerTime).count();
+        m_cpuEnergy += uint64_t(power * timeDiffMicro);
+    }
+    m_cpuPowerTime = now;
+
+    m_cpuPower = power;
+    m_cpuDataTotal.power = int(power + 0.5f);
 
     return true;
 }
 
-static bool find_temp_input(const std::string path, std::string& input, const std::string& name)
-{
-    auto files = ls(path.c_str(), "temp", LS_FILES);
-    for (auto& file : files) {
-        if (!ends_with(file, "_label"))
-            continue;
-
-        auto label = read_line(path + "/" + file);
-        if (label != name)
-            continue;
-
-        auto uscore = file.find_first_of("_");
-        if (uscore != std::string::npos) {
-            file.erase(uscore, std::string::npos);
-            input = path + "/" + file + "_input";
-            return true;
-        }
-    }
-    return false;
-}
-
-static bool find_fallback_temp_input(const std::string path, std::string& input)
-{
-    auto files = ls(path.c_str(), "temp", LS_FILES);
-    if (!files.size())
-        return false;
-
-    std::sort(files.begin(), files.end());
-    for (auto& file : files) {
-        if (!ends_with(file, "_input"))
-            continue;
-        input = path + "/" + file;
-#ifndef NDEBUG
-        std::cerr << "fallback cpu temp input: " << input << "\n";
-#endif
-        return true;
-    }
-    return false;
+const std::vector<rapl_domain>& CPUStats::GetRaplDomains() const {
+    static const std::vector<rapl_domain> none;
+    if (!m_cpuPowerData || m_cpuPowerData->source != CPU_POWER_RAPL)
+        return none;
+    return ((CPUPowerData_rapl*)m_cpuPowerData.get())->domains;
 }
 
 bool CPUStats::GetCpuFile() {
-    if (m_cpuTempFile)
+    if (!m_cpuTemp.empty())
         return true;
 
-    std::string name, path, input;
-    std::string hwmon = "/sys/class/hwmon/";
+    std::string input;
+    const sensor_chip *chip = nullptr;
 
-    auto dirs = ls(hwmon.c_str());
-    for (auto& dir : dirs) {
-        path = hwmon + dir;
-        name = read_line(path + "/name");
+    sensors.init();
+    for (auto& c : sensors.chips()) {
+        if (c.cls != SENSOR_HWMON)
+            continue;
 #ifndef NDEBUG
-        std::cerr << "hwmon: sensor name: " << name << std::endl;
+        std::cerr << "hwmon: sensor name: " << c.name << std::endl;
 #endif
-        if (name == "coretemp") {
-            find_temp_input(path, input, "Package id 0");
+        if (c.name == "coretemp") {
+            sensors.find_input(c, "temp", "Package id 0", input);
+            chip = &c;
             break;
         }
-        else if ((name == "zenpower" || name == "k10temp")) {
-            find_temp_input(path, input, "Tdie");
+        else if ((c.name == "zenpower" || c.name == "k10temp")) {
+            sensors.find_input(c, "temp", "Tdie", input);
+            chip = &c;
             break;
-        } else if (name == "atk0110") {
-            find_temp_input(path, input, "CPU Temperature");
+        } else if (c.name == "atk0110") {
+            sensors.find_input(c, "temp", "CPU Temperature", input);
+            chip = &c;
             break;
-        } else {
-            path.clear();
         }
     }
 
-    if (path.empty() || (!file_exists(input) && !find_fallback_temp_input(path, input))) {
+    if (!chip || (!file_exists(input) && !sensors.first_input(*chip, "temp", input))) {
         std::cerr << "MANGOHUD: Could not find cpu temp sensor location" << std::endl;
         return false;
     } else {
 #ifndef NDEBUG
         std::cerr << "hwmon: using input: " << input << std::endl;
 #endif
-        m_cpuTempFile = fopen(input.c_str(), "r");
-    }
-    return true;
-}
-
-static bool find_voltage_input(const std::string path, std::string& input, const std::string& name)
-{
-    auto files = ls(path.c_str(), "in", LS_FILES);
-    for (auto& file : files) {
-        if (!ends_with(file, "_label"))
-            continue;
-
-        auto label = read_line(path + "/" + file);
-        if (label != name)
-            continue;
-
-        auto uscore = file.find_first_of("_");
-        if (uscore != std::string::npos) {
-            file.erase(uscore, std::string::npos);
-            input = path + "/" + file + "_input";
-            return true;
-        }
-    }
-    return false;
-}
-
-static bool find_current_input(const std::string path, std::string& input, const std::string& name)
-{
-    auto files = ls(path.c_str(), "curr", LS_FILES);
-    for (auto& file : files) {
-        if (!ends_with(file, "_label"))
-            continue;
-
-        auto label = read_line(path + "/" + file);
-        if (label != name)
-            continue;
-
-        auto uscore = file.find_first_of("_");
-        if (uscore != std::string::npos) {
-            file.erase(uscore, std::string::npos);
-            input = path + "/" + file + "_input";
-            return true;
-        }
-    }
-    return false;
-}
-
-static bool find_power_input(const std::string path, std::string& input, const std::string& name)
-{
-    auto files = ls(path.c_str(), "power", LS_FILES);
-    for (auto& file : files) {
-        if (!ends_with(file, "_label"))
-            continue;
-
-        auto label = read_line(path + "/" + file);
-        if (label != name)
-            continue;
-
-        auto uscore = file.find_first_of("_");
-        if (uscore != std::string::npos) {
-            file.erase(uscore, std::string::npos);
-            input = path + "/" + file + "_input";
-            return true;
+        if (m_cpuTemp.add(input) < 0) {
+            std::cerr << "MANGOHUD: Could not open cpu temp sensor " << input << std::endl;
+            return false;
         }
     }
-    return false;
+    return true;
 }
 
-CPUPowerData_k10temp* init_cpu_power_data_k10temp(const std::string path) {
+CPUPowerData_k10temp* init_cpu_power_data_k10temp(const sensor_chip& chip) {
     auto powerData = std::make_unique<CPUPowerData_k10temp>();
 
     std::string coreVoltageInput, coreCurrentInput;
     std::string socVoltageInput, socCurrentInput;
 
-    if(!find_voltage_input(path, coreVoltageInput, "Vcore")) return nullptr;
-    if(!find_current_input(path, coreCurrentInput, "Icore")) return nullptr;
-    if(!find_voltage_input(path, socVoltageInput, "Vsoc")) return nullptr;
-    if(!find_current_input(path, socCurrentInput, "Isoc")) return nullptr;
+    if(!sensors.find_input(chip, "in", "Vcore", coreVoltageInput)) return nullptr;
+    if(!sensors.find_input(chip, "curr", "Icore", coreCurrentInput)) return nullptr;
+    if(!sensors.find_input(chip, "in", "Vsoc", socVoltageInput)) return nullptr;
+    if(!sensors.find_input(chip, "curr", "Isoc", socCurrentInput)) return nullptr;
 
 #ifndef NDEBUG
     std::cerr << "hwmon: using input: " << coreVoltageInput << std::endl;
@@ -513,40 +524,62 @@ CPUPowerData_k10temp* init_cpu_power_data_k10temp(const std::string path) {
     std::cerr << "hwmon: using input: " << socCurrentInput << std::endl;
 #endif
 
-    powerData->coreVoltageFile = fopen(coreVoltageInput.c_str(), "r");
-    powerData->coreCurrentFile = fopen(coreCurrentInput.c_str(), "r");
-    powerData->socVoltageFile = fopen(socVoltageInput.c_str(), "r");
-    powerData->socCurrentFile = fopen(socCurrentInput.c_str(), "r");
+    powerData->coreVoltage = powerData->counters.add(coreVoltageInput);
+    powerData->coreCurrent = powerData->counters.add(coreCurrentInput);
+    powerData->socVoltage = powerData->counters.add(socVoltageInput);
+    powerData->socCurrent = powerData->counters.add(socCurrentInput);
 
     return powerData.release();
 }
 
-CPUPowerData_zenpower* init_cpu_power_data_zenpower(const std::string path) {
+CPUPowerData_zenpower* init_cpu_power_data_zenpower(const sensor_chip& chip) {
     auto powerData = std::make_unique<CPUPowerData_zenpower>();
 
     std::string corePowerInput, socPowerInput;
 
-    if(!find_power_input(path, corePowerInput, "SVI2_P_Core")) return nullptr;
-    if(!find_power_input(path, socPowerInput, "SVI2_P_SoC")) return nullptr;
+    if(!sensors.find_input(chip, "power", "SVI2_P_Core", corePowerInput)) return nullptr;
+    if(!sensors.find_input(chip, "power", "SVI2_P_SoC", socPowerInput)) return nullptr;
 
 #ifndef NDEBUG
     std::cerr << "hwmon: using input: " << corePowerInput << std::endl;
     std::cerr << "hwmon: using input: " << socPowerInput << std::endl;
 #endif
 
-    powerData->corePowerFile = fopen(corePowerInput.c_str(), "r");
-    powerData->socPowerFile = fopen(socPowerInput.c_str(), "r");
+    powerData->corePower = powerData->counters.add(corePowerInput);
+    powerData->socPower = powerData->counters.add(socPowerInput);
 
     return powerData.release();
 }
 
-CPUPowerData_rapl* init_cpu_power_data_rapl(const std::string path) {
+CPUPowerData_rapl* init_cpu_power_data_rapl() {
     auto powerData = std::make_unique<CPUPowerData_rapl>();
 
-    std::string energyCounterPath = path + "/energy_uj";
-    if (!file_exists(energyCounterPath)) return nullptr;
+    for (auto& chip : sensors.chips()) {
+        // intel-rapl:P for package P, intel-rapl:P:N for its subdomains.
+        // intel-rapl-mmio duplicates the packages and psys is the whole platform.
+        auto zone = chip.path.substr(chip.path.find_last_of('/') + 1);
+        if (chip.cls != SENSOR_POWERCAP || !starts_with(zone, "intel-rapl:") || chip.name == "psys")
+            continue;
+
+        rapl_domain domain;
+        domain.name = chip.name;
+        domain.package = atoi(zone.c_str() + strlen("intel-rapl:"));
+        domain.energyCounter = powerData->counters.add(chip.path + "/energy_uj");
+        if (domain.energyCounter < 0)
+            continue;
+        domain.maxEnergyRange = strtoull(read_line(chip.path + "/max_energy_range_uj").c_str(), nullptr, 10);
+
+#ifndef NDEBUG
+        std::cerr << "powercap: " << zone << ": " << domain.name
+                  << ", max_energy_range_uj " << domain.maxEnergyRange << std::endl;
+#endif
+        powerData->domains.push_back(domain);
+    }
 
-    powerData->energyCounterFile = fopen(energyCounterPath.c_str(), "r");
+    bool hasPackage = std::any_of(powerData->domains.begin(), powerData->domains.end(),
+                                  [](const rapl_domain& d) { return starts_with(d.name, "package"); });
+    if (!hasPackage)
+        return nullptr;
 
     return powerData.release();
 }
@@ -555,42 +588,26 @@ bool CPUStats::InitCpuPowerData() {
     if(m_cpuPowerData != nullptr)
         return true;
 
-    std::string name, path;
-    std::string hwmon = "/sys/class/hwmon/";
-
     CPUPowerData* cpuPowerData = nullptr;
 
-    auto dirs = ls(hwmon.c_str());
-    for (auto& dir : dirs) {
-        path = hwmon + dir;
-        name = read_line(path + "/name");
+    sensors.init();
+    for (auto& chip : sensors.chips()) {
+        if (chip.cls != SENSOR_HWMON)
+            continue;
 #ifndef NDEBUG
-        std::cerr << "hwmon: sensor name: " << name << std::endl;
+        std::cerr << "hwmon: sensor name: " << chip.name << std::endl;
 #endif
-        if (name == "k10temp") {
-            cpuPowerData = (CPUPowerData*)init_cpu_power_data_k10temp(path);
+        if (chip.name == "k10temp") {
+            cpuPowerData = (CPUPowerData*)init_cpu_power_data_k10temp(chip);
             break;
-        } else if (name == "zenpower") {
-            cpuPowerData = (CPUPowerData*)init_cpu_power_data_zenpower(path);
+        } else if (chip.name == "zenpower") {
+            cpuPowerData = (CPUPowerData*)init_cpu_power_data_zenpower(chip);
             break;
         }
     }
 
-    if (!cpuPowerData) {
-        std::string powercap = "/sys/class/powercap/";
-        auto powercap_dirs = ls(powercap.c_str());
-        for (auto& dir : powercap_dirs) {
-            path = powercap + dir;
-            name = read_line(path + "/name");
-#ifndef NDEBUG
-            std::cerr << "powercap: name: " << name << std::endl;
-#endif
-            if (name == "package-0") {
-                cpuPowerData = (CPUPowerData*)init_cpu_power_data_rapl(path);
-                break;
-            }
-        }
-    }
+    if (!cpuPowerData)
+        cpuPowerData = (CPUPowerData*)init_cpu_power_data_rapl();
 
     if(cpuPowerData == nullptr) {
         std::cerr << "MANGOHUD: Failed to initialize CPU power data" << std::endl;
@@ -601,4 +618,36 @@ bool CPUStats::InitCpuPowerData() {
     return true;
 }
 
+void CPUStats::QueueCPUData(io_uring_reader& reader) {
+    m_procStat.queue(reader);
+}
+
+void CPUStats::QueueCoreMhz(io_uring_reader& reader) {
+    InitCoreMhz();
+    m_cpuFreq.queue(reader);
+}
+
+void CPUStats::QueueCpuTemp(io_uring_reader& reader) {
+    m_cpuTemp.queue(reader);
+}
+
+void CPUStats::QueueCpuPower(io_uring_reader& reader) {
+    if (!m_cpuPowerData)
+        return;
+
+    switch(m_cpuPowerData->source) {
+        case CPU_POWER_K10TEMP:
+            ((CPUPowerData_k10temp*)m_cpuPowerData.get())->counters.queue(reader);
+            break;
+        case CPU_POWER_ZENPOWER:
+            ((CPUPowerData_zenpower*)m_cpuPowerData.get())->counters.queue(reader);
+            break;
+        case CPU_POWER_RAPL:
+            ((CPUPowerData_rapl*)m_cpuPowerData.get())->counters.queue(reader);
+            break;
+        default:
+            break;
+    }
+}
+
 CPUStats cpuStats;
@@ -6,8 +6,10 @@
 #include <cstdint>
 #include <cstdio>
 #include <memory>
+#include <string>
 
 #include "timing.hpp"
+#include "sysfs_counters.h"
 
 typedef struct CPUData_ {
    unsigned long long int totalTime;
@@ -49,6 +51,7 @@ enum {
 };
 
 struct CPUPowerData {
+   virtual ~CPUPowerData() = default;
    int source;
 };
 
@@ -57,21 +60,11 @@ struct CPUPowerData_k10temp : public CPUPowerData {
       this->source = CPU_POWER_K10TEMP;
    };
 
-   ~CPUPowerData_k10temp() {
-      if(this->coreVoltageFile)
-         fclose(this->coreVoltageFile);
-      if(this->coreCurrentFile)
-         fclose(this->coreCurrentFile);
-      if(this->socVoltageFile)
-         fclose(this->socVoltageFile);
-      if(this->socCurrentFile)
-         fclose(this->socCurrentFile);
-   };
-
-   FILE* coreVoltageFile {nullptr};
-   FILE* coreCurrentFile {nullptr};
-   FILE* socVoltageFile {nullptr};
-   FILE* socCurrentFile {nullptr};
+   counter_set counters;
+   int coreVoltage {-1};
+   int coreCurrent {-1};
+   int socVoltage {-1};
+   int socCurrent {-1};
 };
 
 struct CPUPowerData_zenpower : public CPUPowerData {
@@ -79,31 +72,32 @@ struct CPUPowerData_zenpower : public CPUPowerData {
       this->source = CPU_POWER_ZENPOWER;
    };
 
-   ~CPUPowerData_zenpower() {
-      if(this->corePowerFile)
-         fclose(this->corePowerFile);
-      if(this->socPowerFile)
-         fclose(this->socPowerFile);
-   };
+   counter_set counters;
+   int corePower {-1};
+   int socPower {-1};
+};
 
-   FILE* corePowerFile {nullptr};
-   FILE* socPowerFile {nullptr};
+// A powercap zone or subzone, e.g. intel-rapl:1 (package-1) or intel-rapl:0:2 (dram)
+struct rapl_domain {
+   std::string name;
+   int package {0};
+   int energyCounter {-1};
+   // energy_uj wraps around to 0 after this
+   uint64_t maxEnergyRange {0};
+   uint64_t lastCounterValue {0};
+   bool hasLastCounterValue {false};
+   uint64_t energy {0}; // uJ since the first sample
+   float power {0};     // W
 };
 
 struct CPUPowerData_rapl : public CPUPowerData {
    CPUPowerData_rapl() {
       this->source = CPU_POWER_RAPL;
-      this->lastCounterValue = 0;
       this->lastCounterValueTime = Clock::now();
    };
 
-   ~CPUPowerData_rapl() {
-      if(this->energyCounterFile)
-         fclose(this->energyCounterFile);
-   };
-
-   FILE* energyCounterFile {nullptr};
-   uint64_t lastCounterValue;
+   counter_set counters;
+   std::vector<rapl_domain> domains;
    Clock::time_point lastCounterValueTime;
 };
 
@@ -124,6 +118,13 @@ public:
    bool UpdateCpuPower();
    bool GetCpuFile();
    bool InitCpuPowerData();
+#ifdef __gnu_linux__
+   // Queue the reads of the matching Update* call on a batched reader
+   void QueueCPUData(io_uring_reader& reader);
+   void QueueCoreMhz(io_uring_reader& reader);
+   void QueueCpuTemp(io_uring_reader& reader);
+   void QueueCpuPower(io_uring_reader& reader);
+#endif
    double GetCPUPeriod() { return m_cpuPeriod; }
 
    const std::vector<CPUData>& GetCPUData() const {
@@ -132,16 +133,32 @@ public:
    const CPUData& GetCPUDataTotal() const {
       return m_cpuDataTotal;
    }
+   // CPU power in W with mW precision, GetCPUDataTotal().power is rounded
+   float GetCPUPower() const { return m_cpuPower; }
+   // Energy used by the CPU since power sampling started, in uJ
+   uint64_t GetCPUEnergy() const { return m_cpuEnergy; }
+   // Every RAPL package and subdomain, empty with other power sources
+   const std::vector<rapl_domain>& GetRaplDomains() const;
 private:
+   void InitCoreMhz();
+
    unsigned long long int m_boottime = 0;
    std::vector<CPUData> m_cpuData;
    CPUData m_cpuDataTotal {};
-   std::vector<int> m_coreMhz;
    double m_cpuPeriod = 0;
    bool m_updatedCPUs = false; // TODO use caching or just update?
    bool m_inited = false;
-   FILE *m_cpuTempFile = nullptr;
+   counter_set m_cpuTemp;
    std::unique_ptr<CPUPowerData> m_cpuPowerData;
+   float m_cpuPower = 0;
+   uint64_t m_cpuEnergy = 0;
+   Clock::time_point m_cpuPowerTime {};
+#ifdef __gnu_linux__
+   counter_set m_procStat;
+   counter_set m_cpuFreq;
+   std::vector<int> m_cpuFreqIdx;
+   bool m_cpuFreqInited = false;
+#endif
 };
 
 extern CPUStats cpuStats;
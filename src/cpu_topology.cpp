@@ -0,0 +1,140 @@
+#include "cpu_topology.h"
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <map>
+#include "file_utils.h"
+#include "string_utils.h"
+
+CpuTopology cpuTopology;
+
+std::vector<unsigned> parse_cpu_list(const std::string& list)
+{
+    std::vector<unsigned> cpus;
+    const char *p = list.c_str();
+    while (*p) {
+        char *end;
+        unsigned first = strtoul(p, &end, 10);
+        if (end == p)
+            break;
+        unsigned last = first;
+        p = end;
+        if (*p == '-') {
+            last = strtoul(p + 1, &end, 10);
+            if (end == p + 1)
+                break;
+            p = end;
+        }
+        for (unsigned cpu = first; cpu <= last; cpu++)
+            cpus.push_back(cpu);
+        if (*p != ',')
+            break;
+        p++;
+    }
+    return cpus;
+}
+
+// CPUs with the same list share a group, numbered in the order of their first CPU
+static void group_by_list(std::vector<cpu_group>& groups, const std::vector<unsigned>& cpus,
+                          const char *name, const char *key,
+                          const std::function<std::string(unsigned)>& list_of)
+{
+    std::map<std::string, size_t> seen;
+    for (unsigned cpu : cpus) {
+        std::string list = list_of(cpu);
+        trim(list);
+        if (list.empty())
+            continue;
+        auto it = seen.find(list);
+        if (it == seen.end()) {
+            it = seen.emplace(list, groups.size()).first;
+            std::string n = std::to_string(groups.size());
+            groups.push_back({std::string(name) + n, std::string(key) + n, {}});
+        }
+        groups[it->second].cpus.push_back(cpu);
+    }
+}
+
+void CpuTopology::InitTypes(const std::vector<unsigned>& cpus, const std::string& root, const std::string& pmu_root)
+{
+    auto& groups = m_groups[CORE_LOAD_GROUP_TYPE];
+
+    // Intel hybrid parts have a PMU per core type
+    static const struct { const char *pmu, *name, *key; } types[] = {
+        { "cpu_core", "P-core", "pcore" },
+        { "cpu_atom", "E-core", "ecore" },
+    };
+    for (auto& t : types) {
+        std::string list = read_line(pmu_root + t.pmu + "/cpus");
+        if (!list.empty())
+            groups.push_back({t.name, t.key, parse_cpu_list(list)});
+    }
+    if (!groups.empty())
+        return;
+
+    // ARM big.LITTLE and the like, biggest cores first
+    std::map<unsigned, std::vector<unsigned>, std::greater<unsigned>> capacities;
+    for (unsigned cpu : cpus) {
+        std::string capacity = read_line(root + "cpu" + std::to_string(cpu) + "/cpu_capacity");
+        if (!capacity.empty())
+            capacities[atoi(capacity.c_str())].push_back(cpu);
+    }
+    // one type is nothing to compare
+    if (capacities.size() < 2)
+        return;
+    for (auto& c : capacities)
+        groups.push_back({"Cap " + std::to_string(c.first), "cap" + std::to_string(c.first), c.second});
+}
+
+bool CpuTopology::Init(const std::string& root, const std::string& pmu_root)
+{
+    std::vector<unsigned> cpus;
+    for (auto& cpu : ls(root.c_str(), "cpu", LS_DIRS)) {
+        if (cpu.size() < 4 || cpu[3] < '0' || cpu[3] > '9')
+            continue;
+        cpus.push_back(atoi(cpu.c_str() + 3));
+    }
+    std::sort(cpus.begin(), cpus.end());
+    if (cpus.empty()) {
+        m_inited.store(true, std::memory_order_release);
+        return false;
+    }
+
+    // SMT siblings, core_cpus_list since 5.6
+    group_by_list(m_groups[CORE_LOAD_GROUP_CORE], cpus, "Core ", "core", [&](unsigned cpu) {
+        std::string dir = root + "cpu" + std::to_string(cpu) + "/topology/";
+        std::string list = read_line(dir + "core_cpus_list");
+        return list.empty() ? read_line(dir + "thread_siblings_list") : list;
+    });
+
+    // index3 is the L3 on x86, but the numbering is per architecture
+    group_by_list(m_groups[CORE_LOAD_GROUP_L3], cpus, "L3 ", "l3_", [&](unsigned cpu) {
+        std::string dir = root + "cpu" + std::to_string(cpu) + "/cache/";
+        for (auto& index : ls(dir.c_str(), "index", LS_DIRS))
+            if (atoi(read_line(dir + index + "/level").c_str()) == 3)
+                return read_line(dir + index + "/shared_cpu_list");
+        return std::string();
+    });
+
+    InitTypes(cpus, root, pmu_root);
+
+#ifndef NDEBUG
+    std::cerr << "MANGOHUD: " << cpus.size() << " CPUs, "
+              << m_groups[CORE_LOAD_GROUP_CORE].size() << " cores, "
+              << m_groups[CORE_LOAD_GROUP_L3].size() << " L3 domains, "
+              << m_groups[CORE_LOAD_GROUP_TYPE].size() << " core types\n";
+#endif
+    m_inited.store(true, std::memory_order_release);
+    return true;
+}
+
+std::vector<const cpu_group*> CpuTopology::Select(const std::vector<core_load_group>& kinds) const
+{
+    std::vector<const cpu_group*> groups;
+    for (auto kind : kinds)
+        for (auto& group : m_groups[kind])
+            if (groups.size() < CPU_MAX_GROUPS)
+                groups.push_back(&group);
+    return groups;
+}
@@ -0,0 +1,47 @@
+#pragma once
+#ifndef MANGOHUD_CPU_TOPOLOGY_H
+#define MANGOHUD_CPU_TOPOLOGY_H
+
+#include <atomic>
+#include <string>
+#include <vector>
+#include "overlay_params.h"
+
+// groups shown by core_load and logged, at most
+#define CPU_MAX_GROUPS 128
+
+// Logical CPUs that share a physical core, an L3 cache or a core type
+struct cpu_group {
+    std::string name;               // "Core 3", "L3 1", "P-core", for the HUD
+    std::string key;                // "core3", "l3_1", "pcore", for log columns
+    std::vector<unsigned> cpus;     // CPU numbers, as in /proc/stat
+};
+
+// CPU topology parsed once from cpuN/topology, cpuN/cache and the hybrid
+// cpu_core/cpu_atom PMUs, or cpu_capacity where there are none
+class CpuTopology
+{
+public:
+    // the roots are only something else for a recorded tree
+    bool Init(const std::string& root = "/sys/devices/system/cpu/",
+              const std::string& pmu_root = "/sys/devices/");
+    // set once the groups are built, they don't change after
+    bool IsInitialized() const { return m_inited.load(std::memory_order_acquire); }
+
+    const std::vector<cpu_group>& Groups(core_load_group kind) const { return m_groups[kind]; }
+    // the groups of kinds in that order, at most CPU_MAX_GROUPS
+    std::vector<const cpu_group*> Select(const std::vector<core_load_group>& kinds) const;
+
+private:
+    void InitTypes(const std::vector<unsigned>& cpus, const std::string& root, const std::string& pmu_root);
+
+    std::vector<cpu_group> m_groups[CORE_LOAD_GROUP_MAX];
+    std::atomic<bool> m_inited {false};
+};
+
+// "0-3,8-11" to 0 1 2 3 8 9 10 11
+std::vector<unsigned> parse_cpu_list(const std::string& list);
+
+extern CpuTopology cpuTopology;
+
+#endif //MANGOHUD_CPU_TOPOLOGY_H
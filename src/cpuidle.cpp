@@ -0,0 +1,123 @@
+#include "cpuidle.h"
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include "file_utils.h"
+#include "string_utils.h"
+#include "mesa/util/os_time.h"
+
+CpuIdleStats cpuIdleStats;
+
+bool CpuIdleStats::Init(const std::string& root)
+{
+    m_inited = true;
+
+    for (auto& cpu : ls(root.c_str(), "cpu", LS_DIRS)) {
+        if (cpu.size() < 4 || cpu[3] < '0' || cpu[3] > '9')
+            continue;
+        unsigned n = atoi(cpu.c_str() + 3);
+        std::string dir = root + cpu + "/cpuidle/";
+
+        size_t first = m_states.size();
+        for (unsigned k = 0; ; k++) {
+            std::string path = dir + "state" + std::to_string(k) + "/";
+            std::string name = read_line(path + "name");
+            if (name.empty())
+                break;
+            trim(name);
+            // kept, it may get enabled again meanwhile but isn't the deepest
+            bool disabled = read_line(path + "disable") == "1";
+
+            auto it = std::find(m_names.begin(), m_names.end(), name);
+            if (it == m_names.end()) {
+                if (m_names.size() >= CPUIDLE_MAX_STATES)
+                    continue;
+                it = m_names.insert(m_names.end(), name);
+            }
+
+            state s {};
+            s.cpu = n;
+            s.idx = it - m_names.begin();
+            s.time = m_counters.add(path + "time");
+            s.usage = m_counters.add(path + "usage");
+            if (s.time < 0 || s.usage < 0)
+                continue;
+            s.deepest = !disabled;
+            m_states.push_back(s);
+        }
+
+        // only the last enabled state of the CPU counts as its deepest
+        bool found = false;
+        for (size_t i = m_states.size(); i-- > first; ) {
+            m_states[i].deepest = m_states[i].deepest && !found;
+            found = found || m_states[i].deepest;
+        }
+
+        if (m_states.size() > first) {
+            m_cpus++;
+            m_cores.resize(std::max<size_t>(m_cores.size(), n + 1));
+        }
+    }
+
+    if (m_states.empty()) {
+        std::cerr << "MANGOHUD: No cpuidle states, C-states are not reported\n";
+        return false;
+    }
+#ifndef NDEBUG
+    std::cerr << "MANGOHUD: " << m_names.size() << " cpuidle states on " << m_cpus << " CPUs\n";
+#endif
+    return true;
+}
+
+bool CpuIdleStats::Update()
+{
+    if (m_states.empty())
+        return false;
+
+    m_sample.valid = false;
+    m_counters.update();
+
+    uint64_t now = os_time_get_nano();
+    uint64_t elapsed = now - m_lastTime;
+    bool first = m_lastTime == 0;
+    m_lastTime = now;
+
+    float time[CPUIDLE_MAX_STATES] {};
+    float usage[CPUIDLE_MAX_STATES] {};
+    for (auto& core : m_cores)
+        core = {};
+
+    for (auto& s : m_states) {
+        int64_t t, u;
+        if (!m_counters.get(s.time, t) || !m_counters.get(s.usage, u))
+            continue;
+        // us and counts, a CPU going offline resets them
+        float dt = t >= s.last_time ? t - s.last_time : 0;
+        float du = u >= s.last_usage ? u - s.last_usage : 0;
+        s.last_time = t;
+        s.last_usage = u;
+
+        time[s.idx] += dt;
+        usage[s.idx] += du;
+        cpuidle_core& core = m_cores[s.cpu];
+        core.rate += du;
+        if (s.deepest)
+            core.deepest = dt;
+    }
+    if (first || !elapsed)
+        return false;
+
+    float us = elapsed / 1000.f;
+    float seconds = elapsed / 1e9f;
+    m_sample.count = m_names.size();
+    for (unsigned i = 0; i < m_sample.count; i++) {
+        m_sample.residency[i] = std::min(100.f, time[i] * 100.f / (us * m_cpus));
+        m_sample.rate[i] = usage[i] / seconds;
+    }
+    for (auto& core : m_cores) {
+        core.deepest = std::min(100.f, core.deepest * 100.f / us);
+        core.rate /= seconds;
+    }
+    m_sample.valid = true;
+    return true;
+}
@@ -0,0 +1,73 @@
+#pragma once
+#ifndef MANGOHUD_CPUIDLE_H
+#define MANGOHUD_CPUIDLE_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "sysfs_counters.h"
+
+class io_uring_reader;
+
+#define CPUIDLE_MAX_STATES 10
+
+// Idle states of all CPUs between two updates, in the order of
+// CpuIdleStats::Name()
+struct cpuidle_sample {
+    bool valid;
+    unsigned count;
+    float residency[CPUIDLE_MAX_STATES];  // % of the time of all CPUs
+    float rate[CPUIDLE_MAX_STATES];       // entries per second, all CPUs
+};
+
+// One CPU between two updates
+struct cpuidle_core {
+    float deepest;  // % of the time in its deepest enabled state
+    float rate;     // entries per second into any state
+};
+
+// Residency and entries of the cpuidle states (POLL, C1, C6...) from
+// /sys/devices/system/cpu/cpuN/cpuidle/stateK/{time,usage}
+class CpuIdleStats
+{
+public:
+    // root is only something else for a recorded tree
+    bool Init(const std::string& root = "/sys/devices/system/cpu/");
+    bool Update();
+    void Queue(io_uring_reader& reader) { m_counters.queue(reader); }
+    bool IsInitialized() const { return m_inited; }
+
+    const cpuidle_sample& Get() const { return m_sample; }
+    // by CPU number, empty for CPUs without cpuidle
+    const std::vector<cpuidle_core>& GetCores() const { return m_cores; }
+    // e.g. "C6", the union of the states of every CPU, hybrid CPUs may
+    // not have the same ones on all cores
+    const std::string& Name(unsigned idx) const { return m_names[idx]; }
+    // fixed once Init() is done, the sampler thread's only, others get
+    // the names from the telemetry snapshot
+    unsigned StateCount() const { return m_names.size(); }
+
+private:
+    struct state {
+        unsigned cpu;
+        unsigned idx;   // into m_names
+        int time;       // us
+        int usage;
+        bool deepest;
+        int64_t last_time;
+        int64_t last_usage;
+    };
+
+    counter_set m_counters;
+    std::vector<state> m_states;
+    std::vector<std::string> m_names;
+    std::vector<cpuidle_core> m_cores;
+    uint64_t m_lastTime = 0;
+    unsigned m_cpus = 0;
+    cpuidle_sample m_sample {};
+    bool m_inited = false;
+};
+
+extern CpuIdleStats cpuIdleStats;
+
+#endif //MANGOHUD_CPUIDLE_H
@@ -0,0 +1,137 @@
+#include "diskstats.h"
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include "file_utils.h"
+#include "mesa/util/os_time.h"
+
+DiskStats diskStats;
+
+// the stat file counts in 512 byte sectors whatever the device uses
+#define DISK_SECTOR_SIZE 512
+
+// Directory the game runs from. Under Wine the exe is the preloader, but
+// Steam and Lutris start the game in its install directory.
+static std::string get_game_dir()
+{
+    std::string exe = get_exe_path();
+    auto n = exe.find_last_of('/');
+    if (n == std::string::npos)
+        return read_symlink("/proc/self/cwd");
+    if (exe.compare(n + 1, 4, "wine") == 0)
+        return read_symlink("/proc/self/cwd");
+    return exe.substr(0, n);
+}
+
+// btrfs and the like give files an anonymous st_dev, the block device is
+// the source of the mount that has that device number
+static bool get_mount_source_dev(dev_t dev, dev_t& block)
+{
+    std::ifstream file("/proc/self/mountinfo");
+    std::string line;
+    char want[32];
+    snprintf(want, sizeof(want), "%u:%u", major(dev), minor(dev));
+
+    // "36 35 0:32 / /home rw,relatime shared:1 - btrfs /dev/nvme0n1p2 rw"
+    while (std::getline(file, line)) {
+        std::istringstream fields(line);
+        std::string id, parent, majmin, field;
+        fields >> id >> parent >> majmin;
+        if (majmin != want)
+            continue;
+        while (fields >> field && field != "-")
+            ;
+        std::string fstype, source;
+        fields >> fstype >> source;
+
+        struct stat st;
+        if (source.compare(0, 5, "/dev/") || stat(source.c_str(), &st) || !S_ISBLK(st.st_mode))
+            continue;
+        block = st.st_rdev;
+        return true;
+    }
+    return false;
+}
+
+bool DiskStats::Init()
+{
+    m_inited = true;
+
+    std::string dir = get_game_dir();
+    struct stat st;
+    if (dir.empty() || stat(dir.c_str(), &st)) {
+        std::cerr << "MANGOHUD: Can't find the install directory of the app, no disk stats\n";
+        return false;
+    }
+
+    dev_t dev = st.st_dev;
+    if (major(dev) == 0 && !get_mount_source_dev(st.st_dev, dev)) {
+        std::cerr << "MANGOHUD: " << dir << " is not on a block device, no disk stats\n";
+        return false;
+    }
+
+    std::string sys = "/sys/dev/block/" + std::to_string(major(dev)) + ":" + std::to_string(minor(dev));
+    std::string target = read_symlink(sys.c_str());
+    m_name = target.substr(target.find_last_of('/') + 1);
+    // eleven fields of up to 20 digits, 17 since 5.5
+    m_idx = m_counters.add(sys + "/stat", 512);
+    if (m_idx < 0) {
+        std::cerr << "MANGOHUD: Can't open " << sys << "/stat, no disk stats\n";
+        return false;
+    }
+
+#ifndef NDEBUG
+    std::cerr << "MANGOHUD: disk stats of " << m_name << " for " << dir << "\n";
+#endif
+    return true;
+}
+
+bool DiskStats::Update()
+{
+    if (m_idx < 0)
+        return false;
+
+    m_sample.valid = false;
+    if (!m_counters.update())
+        return false;
+
+    uint64_t fields[FIELD_MAX];
+    const char *p = m_counters.text(m_idx);
+    for (int i = 0; i < FIELD_MAX; i++) {
+        char *end;
+        fields[i] = strtoull(p, &end, 10);
+        if (end == p)
+            return false;
+        p = end;
+    }
+
+    uint64_t now = os_time_get_nano();
+    uint64_t elapsed = now - m_lastTime;
+    bool first = m_lastTime == 0;
+    m_lastTime = now;
+
+    uint64_t delta[FIELD_MAX];
+    for (int i = 0; i < FIELD_MAX; i++) {
+        // in_flight is not a counter, and the others wrap on 32-bit kernels
+        delta[i] = fields[i] >= m_last[i] ? fields[i] - m_last[i] : 0;
+        m_last[i] = fields[i];
+    }
+    if (first || !elapsed)
+        return false;
+
+    float seconds = elapsed / 1e9f;
+    uint64_t ios = delta[READ_IOS] + delta[WRITE_IOS];
+    m_sample.read = delta[READ_SECTORS] * DISK_SECTOR_SIZE / (1024.f * 1024.f) / seconds;
+    m_sample.write = delta[WRITE_SECTORS] * DISK_SECTOR_SIZE / (1024.f * 1024.f) / seconds;
+    m_sample.read_iops = delta[READ_IOS] / seconds;
+    m_sample.write_iops = delta[WRITE_IOS] / seconds;
+    m_sample.latency = ios ? float(delta[READ_TICKS] + delta[WRITE_TICKS]) / ios : 0.f;
+    m_sample.util = std::min(100.f, delta[IO_TICKS] / (seconds * 1000.f) * 100.f);
+    m_sample.valid = true;
+    return true;
+}
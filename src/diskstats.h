@@ -0,0 +1,63 @@
+#pragma once
+#ifndef MANGOHUD_DISKSTATS_H
+#define MANGOHUD_DISKSTATS_H
+
+#include <stdint.h>
+#include <string>
+#include "sysfs_counters.h"
+
+class io_uring_reader;
+
+// Activity of one block device between two updates
+struct disk_sample {
+    bool valid;
+    float read;         // MiB/s
+    float write;        // MiB/s
+    float read_iops;
+    float write_iops;
+    float latency;      // ms a completed request spent queued and in flight
+    float util;         // % of the time with requests in flight
+};
+
+// Throughput, IOPS and latency of the block device the game is installed
+// on, from the diskstats fields in /sys/dev/block/<major>:<minor>/stat
+class DiskStats
+{
+public:
+    bool Init();
+    bool Update();
+    void Queue(io_uring_reader& reader) { m_counters.queue(reader); }
+    bool IsInitialized() const { return m_inited; }
+
+    const disk_sample& Get() const { return m_sample; }
+    // kernel name of the device, e.g. nvme0n1p2
+    const std::string& Name() const { return m_name; }
+
+private:
+    enum {
+        READ_IOS,
+        READ_MERGES,
+        READ_SECTORS,
+        READ_TICKS,
+        WRITE_IOS,
+        WRITE_MERGES,
+        WRITE_SECTORS,
+        WRITE_TICKS,
+        IN_FLIGHT,
+        IO_TICKS,
+        TIME_IN_QUEUE,
+        FIELD_MAX,
+    };
+
+    counter_set m_counters;
+    int m_idx = -1;
+    std::string m_name;
+    uint64_t m_last[FIELD_MAX] {};
+    uint64_t m_lastTime = 0;
+    disk_sample m_sample {};
+    bool m_inited = false;
+};
+
+extern DiskStats diskStats;
+
+#endif //MANGOHUD_DISKSTATS_H
@@ -0,0 +1,232 @@
+#include "drm_fdinfo.h"
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <iostream>
+#include <unistd.h>
+#include "gpu.h"
+#include "mesa/util/os_time.h"
+
+drm_fdinfo drmFdinfo;
+
+// the fd list is re-read every this many updates, or when a client went away
+#define DRM_FDINFO_RESCAN 8
+
+drm_fdinfo::~drm_fdinfo()
+{
+    if (m_fdDir)
+        closedir(m_fdDir);
+}
+
+// "123 KiB" and the like, in bytes
+static uint64_t parse_size(const char *value)
+{
+    char *end;
+    uint64_t size = strtoull(value, &end, 10);
+    while (*end == ' ')
+        end++;
+    if (!strncmp(end, "KiB", 3))
+        size <<= 10;
+    else if (!strncmp(end, "MiB", 3))
+        size <<= 20;
+    else if (!strncmp(end, "GiB", 3))
+        size <<= 30;
+    return size;
+}
+
+static bool skip_prefix(const char *s, const char *prefix, const char *&rest)
+{
+    size_t len = strlen(prefix);
+    if (strncmp(s, prefix, len))
+        return false;
+    rest = s + len;
+    return true;
+}
+
+// Finds the DRM files among the open fds. Clients that are still open keep
+// their fdinfo file and previous sample.
+void drm_fdinfo::scan()
+{
+    if (!m_fdDir)
+        m_fdDir = opendir("/proc/self/fd");
+    if (!m_fdDir)
+        return;
+    rewinddir(m_fdDir);
+
+    std::vector<client> clients;
+    struct dirent *dp;
+    char link[64], target[64];
+    while ((dp = readdir(m_fdDir))) {
+        if (dp->d_name[0] < '0' || dp->d_name[0] > '9')
+            continue;
+
+        int fd = atoi(dp->d_name);
+        snprintf(link, sizeof(link), "/proc/self/fd/%d", fd);
+        ssize_t len = readlink(link, target, sizeof(target) - 1);
+        if (len <= 0)
+            continue;
+        target[len] = '\0';
+        if (strncmp(target, "/dev/dri/", 9))
+            continue;
+
+        auto it = std::find_if(m_clients.begin(), m_clients.end(),
+                               [fd](const client& c) { return c.fd == fd; });
+        if (it != m_clients.end()) {
+            clients.push_back(std::move(*it));
+            continue;
+        }
+
+        client c {};
+        c.fd = fd;
+        if (c.file.open("/proc/self/fdinfo/" + std::to_string(fd)))
+            clients.push_back(std::move(c));
+    }
+    m_clients = std::move(clients);
+}
+
+// false if the file is not a DRM client of the wanted device
+bool drm_fdinfo::parse(char *buf, std::vector<engine>& engines, uint64_t& id, uint64_t& vram)
+{
+    bool is_drm = false;
+    uint64_t memory = 0, resident = 0, total = 0;
+    bool has_memory = false, has_resident = false;
+
+    auto find_engine = [&engines](const char *name, size_t len) -> engine& {
+        for (auto& e : engines)
+            if (e.name.size() == len && !e.name.compare(0, len, name, len))
+                return e;
+        engines.push_back({std::string(name, len), 0, 0, 1});
+        return engines.back();
+    };
+
+    char *saveptr = nullptr;
+    for (char *line = strtok_r(buf, "\n", &saveptr); line; line = strtok_r(nullptr, "\n", &saveptr)) {
+        char *colon = strchr(line, ':');
+        if (!colon)
+            continue;
+        *colon = '\0';
+        const char *value = colon + 1;
+        while (*value == ' ' || *value == '\t')
+            value++;
+
+        const char *rest;
+        if (!strcmp(line, "drm-driver")) {
+            is_drm = true;
+        } else if (!strcmp(line, "drm-client-id")) {
+            id = strtoull(value, nullptr, 10);
+        } else if (!strcmp(line, "drm-pdev")) {
+            if (!m_pci_dev.empty() && m_pci_dev != value)
+                return false;
+        } else if (skip_prefix(line, "drm-engine-capacity-", rest)) {
+            find_engine(rest, strlen(rest)).capacity = std::max(1ull, strtoull(value, nullptr, 10));
+        } else if (skip_prefix(line, "drm-engine-", rest)) {
+            find_engine(rest, strlen(rest)).busy = strtoull(value, nullptr, 10);
+        } else if (skip_prefix(line, "drm-total-cycles-", rest)) {
+            // xe reports GPU timestamp cycles instead of ns
+            find_engine(rest, strlen(rest)).total = strtoull(value, nullptr, 10);
+        } else if (skip_prefix(line, "drm-cycles-", rest)) {
+            find_engine(rest, strlen(rest)).busy = strtoull(value, nullptr, 10);
+        } else if (!strcmp(line, "drm-memory-vram")) {
+            // amdgpu
+            memory += parse_size(value);
+            has_memory = true;
+        } else if (!strcmp(line, "drm-resident-vram0") || !strcmp(line, "drm-resident-local0")) {
+            // xe and i915 discrete cards
+            resident += parse_size(value);
+            has_resident = true;
+        } else if (!strcmp(line, "drm-total-vram0") || !strcmp(line, "drm-total-local0")) {
+            total += parse_size(value);
+        }
+    }
+
+    vram = has_memory ? memory : has_resident ? resident : total;
+    return is_drm;
+}
+
+bool drm_fdinfo::update(gpuProcInfo& info)
+{
+    if (m_rescan == 0) {
+        scan();
+        m_rescan = DRM_FDINFO_RESCAN;
+    }
+    m_rescan--;
+
+    uint64_t now = os_time_get_nano();
+    uint64_t elapsed = m_last_update ? now - m_last_update : 0;
+    m_last_update = now;
+
+    for (auto& l : m_load)
+        l.second = 0;
+
+    // several fds can be dups of one client
+    std::vector<uint64_t> seen;
+    std::vector<engine> engines;
+    uint64_t vram = 0;
+    bool found = false;
+
+    for (auto& c : m_clients) {
+        ssize_t len = c.file.read(m_buf.data(), m_buf.size());
+        if (len <= 0) {
+            // closed since the last scan
+            m_rescan = 0;
+            c.has_sample = false;
+            continue;
+        }
+
+        engines.clear();
+        uint64_t id = 0, client_vram = 0;
+        if (!parse(m_buf.data(), engines, id, client_vram))
+            continue;
+        if (std::find(seen.begin(), seen.end(), id) != seen.end())
+            continue;
+        seen.push_back(id);
+        found = true;
+        vram += client_vram;
+
+        // the fd number was reused by another client
+        if (c.has_sample && c.id != id)
+            c.has_sample = false;
+
+        for (auto& e : engines) {
+            auto prev = std::find_if(c.engines.begin(), c.engines.end(),
+                                     [&e](const engine& p) { return p.name == e.name; });
+            float percent = -1;
+            if (c.has_sample && prev != c.engines.end() && e.busy >= prev->busy) {
+                if (e.total > prev->total)
+                    percent = 100.f * (e.busy - prev->busy) / (e.total - prev->total);
+                else if (!e.total && elapsed)
+                    percent = 100.f * (e.busy - prev->busy) / elapsed / e.capacity;
+            }
+
+            auto load = std::find_if(m_load.begin(), m_load.end(),
+                                     [&e](const std::pair<std::string, float>& l) { return l.first == e.name; });
+            if (load == m_load.end()) {
+                m_load.emplace_back(e.name, 0.f);
+                load = m_load.end() - 1;
+            }
+            if (percent > 0)
+                load->second += percent;
+        }
+
+        c.id = id;
+        c.engines.swap(engines);
+        c.has_sample = true;
+    }
+
+    if (!found) {
+        info.valid = false;
+        return false;
+    }
+
+    info.valid = true;
+    info.load = 0;
+    info.memoryUsed = vram / (1024.f * 1024.f * 1024.f);
+    info.engine_count = std::min<size_t>(m_load.size(), GPU_PROC_MAX_ENGINES);
+    for (unsigned i = 0; i < info.engine_count; i++) {
+        gpu_engine_load& e = info.engines[i];
+        snprintf(e.name, sizeof(e.name), "%s", m_load[i].first.c_str());
+        e.percent = std::min(m_load[i].second, 100.f);
+        info.load = std::max(info.load, e.percent);
+    }
+    return true;
+}
@@ -0,0 +1,57 @@
+#pragma once
+#ifndef MANGOHUD_DRM_FDINFO_H
+#define MANGOHUD_DRM_FDINFO_H
+
+#include <stdint.h>
+#include <dirent.h>
+#include <string>
+#include <vector>
+#include "file_utils.h"
+
+struct gpuProcInfo;
+
+// GPU usage of this process from the drm-* keys the amdgpu, i915 and xe
+// drivers put in /proc/self/fdinfo of every open DRM file
+class drm_fdinfo
+{
+public:
+    ~drm_fdinfo();
+
+    // only count clients of the device at this PCI address, empty for all
+    void set_device(const std::string& pci_dev) { m_pci_dev = pci_dev; }
+
+    // false if the process has no DRM client the keys could be read from
+    bool update(gpuProcInfo& info);
+
+private:
+    struct engine {
+        std::string name;
+        uint64_t busy;        // ns, or cycles
+        uint64_t total;       // total cycles, 0 for ns based engines
+        uint64_t capacity;
+    };
+
+    struct client {
+        int fd;
+        uint64_t id;
+        pread_file file;
+        std::vector<engine> engines;
+        bool has_sample;
+    };
+
+    void scan();
+    bool parse(char *buf, std::vector<engine>& engines, uint64_t& id, uint64_t& vram);
+
+    DIR *m_fdDir = nullptr;
+    std::string m_pci_dev;
+    std::vector<client> m_clients;
+    std::vector<char> m_buf = std::vector<char>(4096);
+    // engine name -> load of the current pass
+    std::vector<std::pair<std::string, float>> m_load;
+    uint64_t m_last_update = 0;
+    unsigned m_rescan = 0;
+};
+
+extern drm_fdinfo drmFdinfo;
+
+#endif //MANGOHUD_DRM_FDINFO_H
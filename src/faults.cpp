@@ -0,0 +1,75 @@
+#include "faults.h"
+#include <cstring>
+#include <cstdlib>
+#include "sysfs_counters.h"
+
+static counter_set counters;
+static int self_stat = -1;
+static int vmstat = -1;
+
+static void init_fault_stats()
+{
+    static bool inited = false;
+    if (!inited) {
+        self_stat = counters.add("/proc/self/stat", 512);
+        // about 4 KiB, the keys we want are in the first half
+        vmstat = counters.add("/proc/vmstat", 8192);
+        inited = true;
+    }
+}
+
+void queue_fault_stats(io_uring_reader& reader) {
+    init_fault_stats();
+    counters.queue(reader);
+}
+
+fault_counters fault_delta(const fault_counters& a, const fault_counters& b) {
+    auto sub = [](uint64_t x, uint64_t y) { return x >= y ? x - y : 0; };
+    return {
+        sub(a.minflt, b.minflt),
+        sub(a.majflt, b.majflt),
+        sub(a.pswpin, b.pswpin),
+        sub(a.pgmajfault, b.pgmajfault),
+    };
+}
+
+// "pid (comm) state ppid pgrp session tty_nr tpgid flags minflt cminflt majflt ..."
+static bool parse_self_stat(const char *text, fault_counters& c)
+{
+    const char *p = strrchr(text, ')');
+    if (!p)
+        return false;
+    p++;
+
+    for (int field = 1; field <= 10; field++) {
+        while (*p == ' ')
+            p++;
+        if (!*p)
+            return false;
+        if (field == 8)
+            c.minflt = strtoull(p, nullptr, 10);
+        else if (field == 10)
+            c.majflt = strtoull(p, nullptr, 10);
+        p = strchr(p, ' ');
+        if (!p)
+            return field == 10;
+    }
+    return true;
+}
+
+void getFaultStats(fault_counters& total, fault_counters& delta) {
+    init_fault_stats();
+
+    fault_counters prev = total;
+    int64_t value;
+    counters.update();
+    parse_self_stat(counters.text(self_stat), total);
+    if (counters.get(vmstat, "pswpin ", value))
+        total.pswpin = value;
+    if (counters.get(vmstat, "pgmajfault ", value))
+        total.pgmajfault = value;
+
+    // nothing to compare the first update to
+    if (prev.minflt || prev.pgmajfault)
+        delta = fault_delta(total, prev);
+}
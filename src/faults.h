@@ -0,0 +1,24 @@
+#pragma once
+#ifndef MANGOHUD_FAULTS_H
+#define MANGOHUD_FAULTS_H
+
+#include <stdint.h>
+
+// Page faults of the process and swap-ins / major faults of the system
+struct fault_counters {
+    uint64_t minflt;
+    uint64_t majflt;
+    uint64_t pswpin;
+    uint64_t pgmajfault;
+};
+
+class io_uring_reader;
+
+// totals since boot (or process start) and the deltas of the last update
+void getFaultStats(fault_counters& total, fault_counters& delta);
+void queue_fault_stats(io_uring_reader& reader);
+
+// a - b, counters that went backwards give 0
+fault_counters fault_delta(const fault_counters& a, const fault_counters& b);
+
+#endif //MANGOHUD_FAULTS_H
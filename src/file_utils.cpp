@@ -3,6 +3,7 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
+#include <fcntl.h>
 #include <dirent.h>
 #include <limits.h>
 #include <iostream>
@@ -161,6 +162,18 @@ std::string get_data_dir()
     return path;
 }
 
+std::string get_cache_dir()
+{
+    const char* p = getenv("XDG_CACHE_HOME");
+    if (p)
+        return p;
+
+    std::string path = get_home_dir();
+    if (!path.empty())
+        path += "/.cache";
+    return path;
+}
+
 std::string get_config_dir()
 {
     const char* p = getenv("XDG_CONFIG_HOME");
@@ -172,3 +185,37 @@ std::string get_config_dir()
         path += "/.config";
     return path;
 }
+
+pread_file& pread_file::operator=(pread_file&& other) noexcept
+{
+    if (this != &other) {
+        close();
+        m_fd = other.m_fd;
+        other.m_fd = -1;
+    }
+    return *this;
+}
+
+bool pread_file::open(const std::string& path)
+{
+    close();
+    m_fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    return m_fd >= 0;
+}
+
+void pread_file::close()
+{
+    if (m_fd >= 0)
+        ::close(m_fd);
+    m_fd = -1;
+}
+
+ssize_t pread_file::read(char *buf, size_t size) const
+{
+    if (m_fd < 0 || size == 0)
+        return -1;
+
+    ssize_t n = pread(m_fd, buf, size - 1, 0);
+    buf[n > 0 ? n : 0] = '\0';
+    return n;
+}
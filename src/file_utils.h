@@ -4,6 +4,7 @@
 
 #include <string>
 #include <vector>
+#include <sys/types.h>
 
 enum LS_FLAGS
 {
@@ -24,5 +25,33 @@ bool get_wine_exe_name(std::string& name, bool keep_ext = false);
 std::string get_home_dir();
 std::string get_data_dir();
 std::string get_config_dir();
+std::string get_cache_dir();
+
+// Keeps a procfs/sysfs file open so that it can be re-read from the start
+// with a single pread() on every sample instead of reopening it.
+class pread_file
+{
+public:
+    pread_file() = default;
+    explicit pread_file(const std::string& path) { open(path); }
+    ~pread_file() { close(); }
+
+    pread_file(const pread_file&) = delete;
+    pread_file& operator=(const pread_file&) = delete;
+    pread_file(pread_file&& other) noexcept : m_fd(other.m_fd) { other.m_fd = -1; }
+    pread_file& operator=(pread_file&& other) noexcept;
+
+    bool open(const std::string& path);
+    void close();
+    bool is_open() const { return m_fd >= 0; }
+    int fd() const { return m_fd; }
+
+    // Reads at most size - 1 bytes from offset 0 and NUL-terminates buf.
+    // Returns the number of bytes read or -1 on error.
+    ssize_t read(char *buf, size_t size) const;
+
+private:
+    int m_fd = -1;
+};
 
 #endif //MANGOHUD_FILE_UTILS_H
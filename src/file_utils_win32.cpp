@@ -60,8 +60,36 @@ std::string get_data_dir()
     return path;
 }
 
+std::string get_cache_dir()
+{
+    std::string path;
+    return path;
+}
+
 std::string get_config_dir()
 {
     std::string path;
     return path;
 }
+
+pread_file& pread_file::operator=(pread_file&& other) noexcept
+{
+    m_fd = other.m_fd;
+    other.m_fd = -1;
+    return *this;
+}
+
+bool pread_file::open(const std::string& path)
+{
+    return false;
+}
+
+void pread_file::close()
+{
+    m_fd = -1;
+}
+
+ssize_t pread_file::read(char *buf, size_t size) const
+{
+    return -1;
+}
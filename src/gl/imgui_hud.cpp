@@ -11,6 +11,8 @@
 #include "imgui_hud.h"
 #include "notify.h"
 #include "blacklist.h"
+#include "gpu_backend.h"
+#include "sampler.h"
 
 #ifdef HAVE_DBUS
 #include "dbus_info.h"
@@ -52,6 +54,7 @@ static swapchain_stats sw_stats {};
 static state state;
 static uint32_t vendorID;
 static std::string deviceName;
+static bool gpu_named = false;
 
 static notify_thread notifier;
 static bool cfg_inited = false;
@@ -111,8 +114,8 @@ void imgui_create(void *ctx)
     } else {
         vendorID = 0x10de;
     }
-    init_gpu_stats(vendorID, params);
-    get_device_name(vendorID, deviceID, sw_stats);
+    init_gpu_stats(vendorID, params, std::string());
+    gpu_named = false;
     // Setup Dear ImGui context
     IMGUI_CHECKVERSION();
     ImGuiContext *saved_ctx = ImGui::GetCurrentContext();
@@ -152,6 +155,9 @@ void imgui_shutdown()
     std::cerr << __func__ << std::endl;
 #endif
 
+    // sampler holds on to params, started again by the next frame if needed
+    hw_sampler.stop();
+
     if (state.imgui_ctx) {
         ImGui::SetCurrentContext(state.imgui_ctx);
         ImGui_ImplOpenGL3_Shutdown();
@@ -177,6 +183,15 @@ void imgui_render(unsigned int width, unsigned int height)
     if (!state.imgui_ctx)
         return;
 
+    // GL has no device ID, it is known once the GPU probe is done
+    if (!gpu_named && gpus.ready()) {
+        gpu_named = true;
+        if (gpus.primary() >= 0) {
+            const gpu_backend& gpu = *gpus.device(gpus.primary()).backend;
+            get_device_name(gpu.vendor_id(), gpu.device_id(), sw_stats);
+        }
+    }
+
     check_keybinds(sw_stats, params, vendorID);
     update_hud_info(sw_stats, params, vendorID);
 
@@ -1,120 +1,203 @@
 #include "gpu.h"
 #include <inttypes.h>
+#include <iostream>
+#include "file_utils.h"
 #include "nvctrl.h"
+#include "amdgpu_metrics.h"
 #ifdef HAVE_NVML
 #include "nvidia_info.h"
 #endif
+#include "gpu_backend.h"
+#include "overlay_params.h"
+#ifdef __gnu_linux__
+#include "drm_fdinfo.h"
+#include "sensors.h"
+#include "string_utils.h"
+#endif
 
 struct gpuInfo gpu_info;
-amdgpu_files amdgpu {};
+struct gpuProcInfo gpu_proc_info;
+struct gpu_sample gpu_samples[GPU_MAX_SAMPLES];
+unsigned gpu_sample_count = 0;
 
-bool checkNvidia(const char *pci_dev){
-    bool nvSuccess = false;
+void getNvidiaThrottleReasons(){
 #ifdef HAVE_NVML
-    nvSuccess = checkNVML(pci_dev) && getNVMLInfo();
-#endif
-#ifdef HAVE_XNVCTRL
-    if (!nvSuccess)
-        nvSuccess = checkXNVCtrl();
+    if (nvmlSuccess)
+        gpu_info.throttle_reasons = getNVMLThrottleReasons();
 #endif
-#ifdef _WIN32
-    if (!nvSuccess)
-        nvSuccess = checkNVAPI();
+}
+
+void getNvidiaGpuSamples(){
+#ifdef HAVE_NVML
+    if (nvmlSuccess)
+        gpu_sample_count = getNVMLSamples(gpu_samples, GPU_MAX_SAMPLES);
 #endif
-    return nvSuccess;
 }
 
-void getNvidiaGpuInfo(){
+void getGpuProcInfo(uint32_t vendorID, const std::string& pci_dev){
 #ifdef HAVE_NVML
-    if (nvmlSuccess){
-        getNVMLInfo();
-        gpu_info.load = nvidiaUtilization.gpu;
-        gpu_info.temp = nvidiaTemp;
-        gpu_info.memoryUsed = nvidiaMemory.used / (1024.f * 1024.f * 1024.f);
-        gpu_info.CoreClock = nvidiaCoreClock;
-        gpu_info.MemClock = nvidiaMemClock;
-        gpu_info.powerUsage = nvidiaPowerUsage / 1000;
-        gpu_info.memoryTotal = nvidiaMemory.total / (1024.f * 1024.f * 1024.f);
+    // the proprietary driver has no fdinfo keys
+    if (vendorID == 0x10de) {
+        if (!nvmlSuccess || !getNVMLProcessInfo(gpu_proc_info))
+            gpu_proc_info.valid = false;
         return;
     }
 #endif
-#ifdef HAVE_XNVCTRL
-    if (nvctrlSuccess) {
-        getNvctrlInfo();
-        gpu_info.load = nvctrl_info.load;
-        gpu_info.temp = nvctrl_info.temp;
-        gpu_info.memoryUsed = nvctrl_info.memoryUsed / (1024.f);
-        gpu_info.CoreClock = nvctrl_info.CoreClock;
-        gpu_info.MemClock = nvctrl_info.MemClock;
-        gpu_info.powerUsage = 0;
-        gpu_info.memoryTotal = nvctrl_info.memoryTotal;
-        return;
-    }
+#ifdef __gnu_linux__
+    drmFdinfo.set_device(pci_dev);
+    drmFdinfo.update(gpu_proc_info);
 #endif
-#ifdef _WIN32
-nvapi_util();
+}
+
+bool initAmdGpuFiles(amdgpu_files& amdgpu, const std::string& path, const std::string& hwmon){
+    struct amdgpu_metrics metrics;
+
+    // Only keep the text files for what gpu_metrics does not provide
+    pread_file file;
+    if (amdgpu.gpu_metrics < 0 && file.open(path + "/gpu_metrics")) {
+        char buf[1024];
+        ssize_t len = file.read(buf, sizeof(buf));
+        if (len > 0 && amdgpu_parse_metrics(buf, len, metrics)) {
+            amdgpu.gpu_metrics = amdgpu.counters.add(path + "/gpu_metrics", sizeof(buf));
+            if (amdgpu.gpu_metrics < 0)
+                metrics = {};
+        }
+#ifndef NDEBUG
+        else
+            std::cerr << "MANGOHUD: unsupported gpu_metrics format, using hwmon\n";
 #endif
+    }
+
+    if (amdgpu.busy < 0 && metrics.load < 0)
+        amdgpu.busy = amdgpu.counters.add(path + "/gpu_busy_percent");
+    if (amdgpu.vram_total < 0)
+        amdgpu.vram_total = amdgpu.counters.add(path + "/mem_info_vram_total");
+    if (amdgpu.vram_used < 0)
+        amdgpu.vram_used = amdgpu.counters.add(path + "/mem_info_vram_used");
+
+    if (hwmon.empty())
+        return amdgpu.gpu_metrics >= 0;
+
+    if (amdgpu.core_clock < 0 && metrics.core_clock < 0)
+        amdgpu.core_clock = amdgpu.counters.add(hwmon + "/freq1_input");
+    if (amdgpu.memory_clock < 0 && metrics.memory_clock < 0)
+        amdgpu.memory_clock = amdgpu.counters.add(hwmon + "/freq2_input");
+    if (amdgpu.temp < 0 && metrics.temp < 0)
+        amdgpu.temp = amdgpu.counters.add(hwmon + "/temp1_input");
+    if (amdgpu.power_usage < 0 && metrics.power_usage < 0)
+        amdgpu.power_usage = amdgpu.counters.add(hwmon + "/power1_average");
+    return true;
 }
 
-void getAmdGpuInfo(){
+void getAmdGpuInfo(amdgpu_files& amdgpu, gpuInfo& info){
     int64_t value = 0;
 
-    if (amdgpu.busy) {
-        rewind(amdgpu.busy);
-        fflush(amdgpu.busy);
-        if (fscanf(amdgpu.busy, "%d", &gpu_info.load) != 1)
-            gpu_info.load = 0;
-        gpu_info.load = gpu_info.load;
+    amdgpu.counters.update();
+
+    if (amdgpu.gpu_metrics >= 0) {
+        struct amdgpu_metrics metrics;
+        if (amdgpu_parse_metrics(amdgpu.counters.text(amdgpu.gpu_metrics),
+                                 amdgpu.counters.length(amdgpu.gpu_metrics), metrics)) {
+            if (metrics.load >= 0)
+                info.load = metrics.load;
+            if (metrics.temp >= 0)
+                info.temp = metrics.temp;
+            if (metrics.core_clock >= 0)
+                info.CoreClock = metrics.core_clock;
+            if (metrics.memory_clock >= 0)
+                info.MemClock = metrics.memory_clock;
+            if (metrics.power_usage >= 0)
+                info.powerUsage = metrics.power_usage;
+            info.throttle_reasons = amdgpu_throttle_reasons(metrics);
+        }
     }
 
-    if (amdgpu.temp) {
-        rewind(amdgpu.temp);
-        fflush(amdgpu.temp);
-        if (fscanf(amdgpu.temp, "%d", &gpu_info.temp) != 1)
-            gpu_info.temp = 0;
-        gpu_info.temp /= 1000;
+    if (amdgpu.busy >= 0) {
+        if (!amdgpu.counters.get(amdgpu.busy, value))
+            value = 0;
+        info.load = value;
     }
 
-    if (amdgpu.vram_total) {
-        rewind(amdgpu.vram_total);
-        fflush(amdgpu.vram_total);
-        if (fscanf(amdgpu.vram_total, "%" PRId64, &value) != 1)
+    if (amdgpu.temp >= 0) {
+        if (!amdgpu.counters.get(amdgpu.temp, value))
             value = 0;
-        gpu_info.memoryTotal = float(value) / (1024 * 1024 * 1024);
+        info.temp = value / 1000;
     }
 
-    if (amdgpu.vram_used) {
-        rewind(amdgpu.vram_used);
-        fflush(amdgpu.vram_used);
-        if (fscanf(amdgpu.vram_used, "%" PRId64, &value) != 1)
+    if (amdgpu.vram_total >= 0) {
+        if (!amdgpu.counters.get(amdgpu.vram_total, value))
             value = 0;
-        gpu_info.memoryUsed = float(value) / (1024 * 1024 * 1024);
+        info.memoryTotal = float(value) / (1024 * 1024 * 1024);
     }
 
-    if (amdgpu.core_clock) {
-        rewind(amdgpu.core_clock);
-        fflush(amdgpu.core_clock);
-        if (fscanf(amdgpu.core_clock, "%" PRId64, &value) != 1)
+    if (amdgpu.vram_used >= 0) {
+        if (!amdgpu.counters.get(amdgpu.vram_used, value))
+            value = 0;
+        info.memoryUsed = float(value) / (1024 * 1024 * 1024);
+    }
+
+    if (amdgpu.core_clock >= 0) {
+        if (!amdgpu.counters.get(amdgpu.core_clock, value))
             value = 0;
 
-        gpu_info.CoreClock = value / 1000000;
+        info.CoreClock = value / 1000000;
     }
 
-    if (amdgpu.memory_clock) {
-        rewind(amdgpu.memory_clock);
-        fflush(amdgpu.memory_clock);
-        if (fscanf(amdgpu.memory_clock, "%" PRId64, &value) != 1)
+    if (amdgpu.memory_clock >= 0) {
+        if (!amdgpu.counters.get(amdgpu.memory_clock, value))
             value = 0;
 
-        gpu_info.MemClock = value / 1000000;
+        info.MemClock = value / 1000000;
     }
 
-    if (amdgpu.power_usage) {
-        rewind(amdgpu.power_usage);
-        fflush(amdgpu.power_usage);
-        if (fscanf(amdgpu.power_usage, "%" PRId64, &value) != 1)
+    if (amdgpu.power_usage >= 0) {
+        if (!amdgpu.counters.get(amdgpu.power_usage, value))
             value = 0;
 
-        gpu_info.powerUsage = value / 1000000;
+        info.powerUsage = value / 1000000;
     }
 }
+
+#ifdef __gnu_linux__
+class amdgpu_backend : public gpu_backend
+{
+public:
+    using gpu_backend::gpu_backend;
+
+    const char *name() const override { return "amdgpu"; }
+    bool update(gpuInfo& info) override { getAmdGpuInfo(files, info); return true; }
+    void queue(io_uring_reader& reader) override { files.counters.queue(reader); }
+
+    amdgpu_files files;
+};
+
+// every card of the amdgpu driver under /sys/class/drm
+void probe_amdgpu(const overlay_params& params, gpu_backend_list& devices){
+    sensors.init(params.enabled[OVERLAY_PARAM_ENABLED_sensor_cache]);
+    for (auto& card : sensors.chips()) {
+        if (card.cls != SENSOR_DRM)
+            continue;
+        std::string path = card.path + "/device";
+
+#ifndef NDEBUG
+        std::cerr << "amdgpu path check: " << path << "/vendor" << std::endl;
+#endif
+        std::string line = read_line(path + "/vendor");
+        trim(line);
+        if (line != "0x1002" || !file_exists(path + "/gpu_busy_percent"))
+            continue;
+
+        std::string pci_device = read_symlink(path.c_str());
+        uint32_t device_id = strtol(read_line(path + "/device").c_str(), NULL, 16);
+        auto dev = std::make_unique<amdgpu_backend>(0x1002, device_id, pci_device.substr(pci_device.find_last_of('/') + 1));
+
+        const sensor_chip *hwmon = sensors.find_device(SENSOR_HWMON, card.device);
+        if (!initAmdGpuFiles(dev->files, path, hwmon ? hwmon->path : std::string()))
+            continue;
+#ifndef NDEBUG
+        std::cerr << "using amdgpu path: " << path << std::endl;
+#endif
+        devices.push_back(std::move(dev));
+    }
+}
+#endif
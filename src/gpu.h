@@ -3,20 +3,25 @@
 #define MANGOHUD_GPU_H
 
 #include <stdio.h>
+#include <stdint.h>
+#include <string>
+#include "sysfs_counters.h"
 
+// indices into counters, -1 when the file is not available
 struct amdgpu_files
 {
-    FILE *busy;
-    FILE *temp;
-    FILE *vram_total;
-    FILE *vram_used;
-    FILE *core_clock;
-    FILE *memory_clock;
-    FILE *power_usage;
+    counter_set counters;
+    int busy = -1;
+    int temp = -1;
+    int vram_total = -1;
+    int vram_used = -1;
+    int core_clock = -1;
+    int memory_clock = -1;
+    int power_usage = -1;
+    // binary blob covering most of the above on newer kernels
+    int gpu_metrics = -1;
 };
 
-extern amdgpu_files amdgpu;
-
 struct gpuInfo{
     int load;
     int temp;
@@ -25,13 +30,58 @@ struct gpuInfo{
     int MemClock;
     int CoreClock;
     int powerUsage;
+    // THROTTLE_* reasons
+    unsigned throttle_reasons;
 };
 
 extern struct gpuInfo gpu_info;
 
-void getNvidiaGpuInfo(void);
-void getAmdGpuInfo(void);
-bool checkNvidia(const char *pci_dev);
-extern void nvapi_util();
+// GPUs sampled at the same time
+#define GPU_MAX_DEVICES 8
+
+#define GPU_PROC_MAX_ENGINES 8
+
+struct gpu_engine_load {
+    char name[16];
+    float percent;
+};
+
+// what this process alone uses of the GPU
+struct gpuProcInfo {
+    bool valid;
+    float load;         // busiest engine
+    float memoryUsed;   // GiB
+    unsigned engine_count;
+    struct gpu_engine_load engines[GPU_PROC_MAX_ENGINES];
+};
+
+extern struct gpuProcInfo gpu_proc_info;
+
+#define GPU_MAX_SAMPLES 64
+
+// one entry of the sample buffer the driver fills on its own, NVIDIA only
+struct gpu_sample {
+    uint64_t timestamp; // us, CLOCK_REALTIME
+    int load;
+    int mem_load;
+    int CoreClock;
+    int MemClock;
+};
+
+// the samples taken since the previous sampler pass, oldest first
+extern struct gpu_sample gpu_samples[GPU_MAX_SAMPLES];
+extern unsigned gpu_sample_count;
+
+void getAmdGpuInfo(amdgpu_files& amdgpu, struct gpuInfo& info);
+// From DRM fdinfo, or NVML process accounting on NVIDIA
+void getGpuProcInfo(uint32_t vendorID, const std::string& pci_dev);
+// Registers the sysfs files of the amdgpu device at path and of its hwmon
+// folder, false if neither gpu_metrics nor hwmon is available
+bool initAmdGpuFiles(amdgpu_files& amdgpu, const std::string& path, const std::string& hwmon);
+// NVML is only asked when the reasons are shown, amdgpu gets them for free
+void getNvidiaThrottleReasons(void);
+// Fills gpu_samples with what NVML sampled since the previous call
+void getNvidiaGpuSamples(void);
+extern void nvapi_util(struct gpuInfo& info);
 extern bool checkNVAPI();
 #endif //MANGOHUD_GPU_H
@@ -0,0 +1,160 @@
+#include "gpu_backend.h"
+#include <algorithm>
+#include <iostream>
+#include "overlay_params.h"
+
+gpu_registry gpus;
+
+// A future backend only needs a row here. XNVCtrl goes after NVML as it
+// only adds a device when NVML found none.
+static const struct {
+    const char *name;
+    gpu_probe_func probe;
+} gpu_probes[] = {
+#ifdef __gnu_linux__
+    { "amdgpu", probe_amdgpu },
+    { "intel", probe_intel },
+#endif
+#ifdef HAVE_NVML
+    { "nvml", probe_nvml },
+#endif
+#ifdef HAVE_XNVCTRL
+    { "xnvctrl", probe_xnvctrl },
+#endif
+#ifdef _WIN32
+    { "nvapi", probe_nvapi },
+#endif
+};
+
+gpu_registry::~gpu_registry()
+{
+    wait();
+}
+
+void gpu_registry::init_async(const overlay_params& params, const std::string& pci_dev, uint32_t vendorID)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_bindPci = pci_dev;
+    m_bindVendor = vendorID;
+    // the sampler thread may be reading the devices, it rebinds on its next pass
+    if (ready()) {
+        m_rebind = true;
+        return;
+    }
+    if (m_thread.joinable())
+        return;
+
+    // params may be reloaded meanwhile, the probe works on a copy
+    m_thread = std::thread([this](overlay_params params) {
+        init(params);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!bind_primary(m_bindPci, m_bindVendor))
+            std::cerr << "MANGOHUD: No GPU stats available\n";
+        m_ready.store(true, std::memory_order_release);
+    }, params);
+}
+
+void gpu_registry::wait()
+{
+    if (m_thread.joinable())
+        m_thread.join();
+}
+
+uint32_t gpu_registry::vendor_id() const
+{
+    if (!ready())
+        return 0;
+    int primary = m_primary;
+    return primary < 0 ? 0 : m_devices[primary].backend->vendor_id();
+}
+
+void gpu_registry::init(const overlay_params& params)
+{
+    if (m_inited)
+        return;
+    m_inited = true;
+
+    gpu_backend_list found;
+    for (auto& p : gpu_probes)
+        p.probe(params, found);
+
+    // devices without an address keep their probe order, after the others
+    std::stable_sort(found.begin(), found.end(), [](const std::unique_ptr<gpu_backend>& a,
+                                                    const std::unique_ptr<gpu_backend>& b) {
+        if (a->pci_dev().empty() != b->pci_dev().empty())
+            return b->pci_dev().empty();
+        return a->pci_dev() < b->pci_dev();
+    });
+
+    if (found.size() > GPU_MAX_DEVICES) {
+        std::cerr << "MANGOHUD: Only the first " << GPU_MAX_DEVICES << " of " << found.size() << " GPUs are used\n";
+        found.resize(GPU_MAX_DEVICES);
+    }
+
+    for (auto& backend : found) {
+        size_t idx = m_devices.size();
+        bool selected = params.gpu_list.empty()
+            || std::find(params.gpu_list.begin(), params.gpu_list.end(), idx) != params.gpu_list.end();
+        std::cerr << "MANGOHUD: GPU" << idx << ": " << backend->name() << " "
+                  << (backend->pci_dev().empty() ? "(no PCI address)" : backend->pci_dev()) << "\n";
+        m_devices.push_back({std::move(backend), {}, selected});
+    }
+}
+
+bool gpu_registry::bind_primary(const std::string& pci_dev, uint32_t vendorID)
+{
+    int primary = -1;
+    for (size_t i = 0; i < m_devices.size() && primary < 0; i++)
+        if (!pci_dev.empty() && m_devices[i].backend->pci_dev() == pci_dev)
+            primary = i;
+    for (size_t i = 0; i < m_devices.size() && primary < 0; i++)
+        if (m_devices[i].backend->vendor_id() == vendorID)
+            primary = i;
+    // e.g. the app renders on a GPU no backend can read
+    if (primary < 0 && !m_devices.empty())
+        primary = 0;
+
+    if (primary < 0)
+        return false;
+
+    if (!pci_dev.empty() && m_devices[primary].backend->pci_dev() != pci_dev)
+        std::cerr << "MANGOHUD: No GPU at " << pci_dev << ", showing GPU" << primary << "\n";
+    m_devices[primary].backend->bind();
+    m_primary = primary;
+    return true;
+}
+
+void gpu_registry::apply_rebind()
+{
+    if (!m_rebind.load(std::memory_order_acquire))
+        return;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    bind_primary(m_bindPci, m_bindVendor);
+    m_rebind = false;
+}
+
+void gpu_registry::update()
+{
+    apply_rebind();
+    int primary = m_primary;
+    for (size_t i = 0; i < m_devices.size(); i++) {
+        if (!is_sampled(i))
+            continue;
+        gpu_device& dev = m_devices[i];
+        dev.backend->update(dev.info);
+    }
+
+    // NVIDIA throttle reasons are filled in by their own source, after this one
+    if (primary >= 0)
+        gpu_info = m_devices[primary].info;
+}
+
+#ifdef __gnu_linux__
+void gpu_registry::queue(io_uring_reader& reader)
+{
+    apply_rebind();
+    for (size_t i = 0; i < m_devices.size(); i++)
+        if (is_sampled(i))
+            m_devices[i].backend->queue(reader);
+}
+#endif
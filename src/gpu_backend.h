@@ -0,0 +1,136 @@
+#pragma once
+#ifndef MANGOHUD_GPU_BACKEND_H
+#define MANGOHUD_GPU_BACKEND_H
+
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "gpu.h"
+
+struct overlay_params;
+class io_uring_reader;
+
+// One GPU and the driver interface its stats are read through
+class gpu_backend
+{
+public:
+    gpu_backend(uint32_t vendor_id, uint32_t device_id, const std::string& pci_dev)
+        : m_vendorID(vendor_id), m_deviceID(device_id), m_pciDev(pci_dev) {}
+    virtual ~gpu_backend() = default;
+
+    // e.g. "amdgpu", for messages
+    virtual const char *name() const = 0;
+    // false if the device did not answer
+    virtual bool update(gpuInfo& info) = 0;
+#ifdef __gnu_linux__
+    // optional, queues the reads update() is going to do on the sampler's batch
+    virtual void queue(io_uring_reader&) {}
+#endif
+    // the HUD's gpu stats are about this device now, for backends that
+    // also serve per process stats or throttle reasons of it
+    virtual void bind() {}
+
+    uint32_t vendor_id() const { return m_vendorID; }
+    uint32_t device_id() const { return m_deviceID; }
+    // "0000:03:00.0", empty when the backend can't tell
+    const std::string& pci_dev() const { return m_pciDev; }
+
+private:
+    uint32_t m_vendorID;
+    uint32_t m_deviceID;
+    std::string m_pciDev;
+};
+
+typedef std::vector<std::unique_ptr<gpu_backend>> gpu_backend_list;
+
+// Adds the devices a backend can read, devices already holds what the
+// backends before it found
+typedef void (*gpu_probe_func)(const overlay_params& params, gpu_backend_list& devices);
+
+#ifdef __gnu_linux__
+void probe_amdgpu(const overlay_params& params, gpu_backend_list& devices);
+void probe_intel(const overlay_params& params, gpu_backend_list& devices);
+#endif
+#ifdef HAVE_NVML
+void probe_nvml(const overlay_params& params, gpu_backend_list& devices);
+#endif
+#ifdef HAVE_XNVCTRL
+void probe_xnvctrl(const overlay_params& params, gpu_backend_list& devices);
+#endif
+#ifdef _WIN32
+void probe_nvapi(const overlay_params& params, gpu_backend_list& devices);
+#endif
+
+struct gpu_device {
+    std::unique_ptr<gpu_backend> backend;
+    gpuInfo info;
+    // sampled even when not the primary device
+    bool selected;
+};
+
+// Every GPU some backend can read, sampled together on each sampler pass
+class gpu_registry
+{
+public:
+    ~gpu_registry();
+
+    // Probes and binds the primary device on a background thread, probing
+    // may dlopen libnvidia-ml and try every X display, which the app's
+    // device creation shouldn't wait for. Later calls only have the
+    // sampler thread rebind on its next pass.
+    void init_async(const overlay_params& params, const std::string& pci_dev, uint32_t vendorID);
+    // The devices can't change once true, nothing below is valid before
+    bool ready() const { return m_ready.load(std::memory_order_acquire); }
+    // Blocks until the probe started by init_async() is done
+    void wait();
+
+    // Probes once, devices are ordered by PCI address. gpu_list picks the
+    // devices that are sampled besides the primary one, all if empty.
+    void init(const overlay_params& params);
+    bool IsInitialized() const { return m_inited; }
+
+    // The device the HUD's gpu stats are about: the one at pci_dev, else
+    // the first one of vendorID, else the first one. false if none.
+    bool bind_primary(const std::string& pci_dev, uint32_t vendorID);
+
+    // Reads the primary and the selected devices, the primary one is also
+    // copied to gpu_info. Sampler thread only, like queue().
+    void update();
+#ifdef __gnu_linux__
+    void queue(io_uring_reader& reader);
+#endif
+
+    size_t size() const { return m_devices.size(); }
+    bool empty() const { return m_devices.empty(); }
+    const gpu_device& device(size_t idx) const { return m_devices[idx]; }
+    // index of the primary device, -1 before bind_primary()
+    int primary() const { return m_primary; }
+    bool is_sampled(size_t idx) const { return (int)idx == m_primary || m_devices[idx].selected; }
+    // vendor of the primary device, 0 if not ready or none
+    uint32_t vendor_id() const;
+
+private:
+    // binds what the last init_async() asked for, on the sampler thread
+    void apply_rebind();
+
+    std::vector<gpu_device> m_devices;
+    std::thread m_thread;
+    // guards the bind request of init_async() against the probe thread and
+    // the sampler thread, which do the binding
+    std::mutex m_mutex;
+    std::string m_bindPci;
+    uint32_t m_bindVendor = 0;
+    std::atomic<bool> m_rebind {false};
+    std::atomic<bool> m_ready {false};
+    // also read by the app thread through vendor_id()
+    std::atomic<int> m_primary {-1};
+    bool m_inited = false;
+};
+
+extern gpu_registry gpus;
+
+#endif //MANGOHUD_GPU_BACKEND_H
@@ -1,6 +1,7 @@
 #include <algorithm>
 #include <cmath>
 #include "hud_elements.h"
+#include "throttle.h"
 #include "cpu.h"
 #include "memory.h"
 #include "mesa/util/macros.h"
@@ -101,7 +102,9 @@ void HudElements::version(){
 }
 
 void HudElements::gpu_stats(){
-    if (HUDElements.params->enabled[OVERLAY_PARAM_ENABLED_gpu_stats]){
+    // no row when the GPU probe found nothing
+    bool no_gpu = HUDElements.telemetry.gpu_ready && !HUDElements.telemetry.gpu_count;
+    if (HUDElements.params->enabled[OVERLAY_PARAM_ENABLED_gpu_stats] && !no_gpu){
         ImGui::TableNextRow();
         const char* gpu_text;
         if (HUDElements.params->gpu_text.empty())
@@ -111,6 +114,15 @@ void HudElements::gpu_stats(){
         ImGui::TextColored(HUDElements.colors.gpu, "%s", gpu_text);
         ImGui::TableNextCell();
         auto text_color = HUDElements.colors.text;
+        // the probe runs in the background, don't show zeros meanwhile
+        if (!HUDElements.telemetry.gpu_ready){
+            right_aligned_text(text_color, HUDElements.ralign_width, "%s", "-");
+            if (HUDElements.params->enabled[OVERLAY_PARAM_ENABLED_gpu_temp]){
+                ImGui::TableNextCell();
+                right_aligned_text(text_color, HUDElements.ralign_width, "%s", "-");
+            }
+            return;
+        }
         if (HUDElements.params->enabled[OVERLAY_PARAM_ENABLED_gpu_load_change]){
             struct LOAD_DATA gpu_data = {
                 HUDElements.colors.gpu_load_low,
@@ -120,13 +132,13 @@ void HudElements::gpu_stats(){
                 HUDElements.params->gpu_load_value[1]
             };
 
-            auto load_color = change_on_load_temp(gpu_data, gpu_info.load);
-            right_aligned_text(load_color, HUDElements.ralign_width, "%i", gpu_info.load);
+            auto load_color = change_on_load_temp(gpu_data, HUDElements.telemetry.gpu.load);
+            right_aligned_text(load_color, HUDElements.ralign_width, "%i", HUDElements.telemetry.gpu.load);
             ImGui::SameLine(0, 1.0f);
             ImGui::TextColored(load_color,"%%");
         }
         else {
-            right_aligned_text(text_color, HUDElements.ralign_width, "%i", gpu_info.load);
+            right_aligned_text(text_color, HUDElements.ralign_width, "%i", HUDElements.telemetry.gpu.load);
             ImGui::SameLine(0, 1.0f);
             ImGui::TextColored(text_color,"%%");
             // ImGui::SameLine(150);
@@ -134,7 +146,7 @@ void HudElements::gpu_stats(){
         }
         if (HUDElements.params->enabled[OVERLAY_PARAM_ENABLED_gpu_temp]){
             ImGui::TableNextCell();
-            right_aligned_text(text_color, HUDElements.ralign_width, "%i", gpu_info.temp);
+            right_aligned_text(text_color, HUDElements.ralign_width, "%i", HUDElements.telemetry.gpu.temp);
             ImGui::SameLine(0, 1.0f);
             ImGui::Text("°C");
         }
@@ -142,7 +154,7 @@ void HudElements::gpu_stats(){
             ImGui::TableNextRow();
         if (HUDElements.params->enabled[OVERLAY_PARAM_ENABLED_gpu_core_clock]){
             ImGui::TableNextCell();
-            right_aligned_text(text_color, HUDElements.ralign_width, "%i", gpu_info.CoreClock);
+            right_aligned_text(text_color, HUDElements.ralign_width, "%i", HUDElements.telemetry.gpu.CoreClock);
             ImGui::SameLine(0, 1.0f);
             ImGui::PushFont(HUDElements.sw_stats->font1);
             ImGui::Text("MHz");
@@ -150,12 +162,54 @@ void HudElements::gpu_stats(){
         }
         if (HUDElements.params->enabled[OVERLAY_PARAM_ENABLED_gpu_power]) {
             ImGui::TableNextCell();
-            right_aligned_text(text_color, HUDElements.ralign_width, "%i", gpu_info.powerUsage);
+            right_aligned_text(text_color, HUDElements.ralign_width, "%i", HUDElements.telemetry.gpu.powerUsage);
             ImGui::SameLine(0, 1.0f);
             ImGui::PushFont(HUDElements.sw_stats->font1);
             ImGui::Text("W");
             ImGui::PopFont();
         }
+        const gpuProcInfo& proc = HUDElements.telemetry.gpu_proc;
+        if (HUDElements.params->enabled[OVERLAY_PARAM_ENABLED_proc_gpu_stats] && proc.valid){
+            ImGui::TableNextRow();
+            ImGui::PushFont(HUDElements.sw_stats->font1);
+            ImGui::TextColored(HUDElements.colors.gpu, "App");
+            ImGui::PopFont();
+            ImGui::TableNextCell();
+            right_aligned_text(text_color, HUDElements.ralign_width, "%.0f", proc.load);
+            ImGui::SameLine(0, 1.0f);
+            ImGui::Text("%%");
+            // one engine is the same as the line above
+            for (unsigned i = 0; proc.engine_count > 1 && i < proc.engine_count; i++) {
+                ImGui::TableNextRow();
+                ImGui::PushFont(HUDElements.sw_stats->font1);
+                ImGui::TextColored(HUDElements.colors.gpu, " %s", proc.engines[i].name);
+                ImGui::PopFont();
+                ImGui::TableNextCell();
+                right_aligned_text(text_color, HUDElements.ralign_width, "%.0f", proc.engines[i].percent);
+                ImGui::SameLine(0, 1.0f);
+                ImGui::Text("%%");
+            }
+        }
+        // the other sampled GPUs, one line each
+        for (unsigned i = 0; i < HUDElements.telemetry.gpu_count; i++) {
+            const telemetry_gpu& g = HUDElements.telemetry.gpus[i];
+            if (g.primary)
+                continue;
+            ImGui::TableNextRow();
+            ImGui::PushFont(HUDElements.sw_stats->font1);
+            ImGui::TextColored(HUDElements.colors.gpu, "GPU%u", g.index);
+            ImGui::PopFont();
+            ImGui::TableNextCell();
+            right_aligned_text(text_color, HUDElements.ralign_width, "%i", g.info.load);
+            ImGui::SameLine(0, 1.0f);
+            ImGui::Text("%%");
+            if (HUDElements.params->enabled[OVERLAY_PARAM_ENABLED_gpu_temp]){
+                ImGui::TableNextCell();
+                right_aligned_text(text_color, HUDElements.ralign_width, "%i", g.info.temp);
+                ImGui::SameLine(0, 1.0f);
+                ImGui::Text("°C");
+            }
+        }
     }
 }
 
@@ -172,7 +226,7 @@ void HudElements::cpu_stats(){
         ImGui::TableNextCell();
         auto text_color = HUDElements.colors.text;
         if (HUDElements.params->enabled[OVERLAY_PARAM_ENABLED_cpu_load_change]){
-            int cpu_load_percent = int(cpuStats.GetCPUDataTotal().percent);
+            int cpu_load_percent = int(HUDElements.telemetry.cpu.percent);
             struct LOAD_DATA cpu_data = {
                 HUDElements.colors.cpu_load_low,
                 HUDElements.colors.cpu_load_med,
@@ -187,14 +241,14 @@ void HudElements::cpu_stats(){
             ImGui::TextColored(load_color, "%%");
         }
         else {
-            right_aligned_text(text_color, HUDElements.ralign_width, "%d", int(cpuStats.GetCPUDataTotal().percent));
+            right_aligned_text(text_color, HUDElements.ralign_width, "%d", int(HUDElements.telemetry.cpu.percent));
             ImGui::SameLine(0, 1.0f);
             ImGui::Text("%%");
         }
 
         if (HUDElements.params->enabled[OVERLAY_PARAM_ENABLED_cpu_temp]){
             ImGui::TableNextCell();
-            right_aligned_text(HUDElements.colors.text, HUDElements.ralign_width, "%i", cpuStats.GetCPUDataTotal().temp);
+            right_aligned_text(HUDElements.colors.text, HUDElements.ralign_width, "%i", HUDElements.telemetry.cpu.temp);
             ImGui::SameLine(0, 1.0f);
             ImGui::Text("°C");
         }
@@ -202,7 +256,7 @@ void HudElements::cpu_stats(){
             ImGui::TableNextRow();
         if (HUDElements.params->enabled[OVERLAY_PARAM_ENABLED_cpu_mhz]){
             ImGui::TableNextCell();
-            right_aligned_text(HUDElements.colors.text, HUDElements.ralign_width, "%i", cpuStats.GetCPUDataTotal().cpu_mhz);
+            right_aligned_text(HUDElements.colors.text, HUDElements.ralign_width, "%i", HUDElements.telemetry.cpu.mhz);
             ImGui::SameLine(0, 1.0f);
             ImGui::PushFont(HUDElements.sw_stats->font1);
             ImGui::Text("MHz");
@@ -210,7 +264,7 @@ void HudElements::cpu_stats(){
         }
         if (HUDElements.params->enabled[OVERLAY_PARAM_ENABLED_cpu_power]){
             ImGui::TableNextCell();
-            right_aligned_text(HUDElements.colors.text, HUDElements.ralign_width, "%i", cpuStats.GetCPUDataTotal().power);
+            right_aligned_text(HUDElements.colors.text, HUDElements.ralign_width, "%.0f", HUDElements.telemetry.cpu.power);
             ImGui::SameLine(0, 1.0f);
             ImGui::PushFont(HUDElements.sw_stats->font1);
             ImGui::Text("W");
@@ -220,10 +274,33 @@ void HudElements::cpu_stats(){
 }
 
 void HudElements::core_load(){
+    // average and busiest CPU of each core_load_group group
+    if (HUDElements.params->enabled[OVERLAY_PARAM_ENABLED_core_load] && !HUDElements.params->core_load_group.empty()){
+        for (unsigned i = 0; i < HUDElements.telemetry.cpu_group_count; i++) {
+            const telemetry_cpu_group& group = HUDElements.telemetry.cpu_groups[i];
+            ImGui::TableNextRow();
+            ImGui::PushFont(HUDElements.sw_stats->font1);
+            ImGui::TextColored(HUDElements.colors.cpu, "%s", group.name);
+            ImGui::PopFont();
+            ImGui::TableNextCell();
+            right_aligned_text(HUDElements.colors.text, HUDElements.ralign_width, "%i", int(group.avg));
+            ImGui::SameLine(0, 1.0f);
+            ImGui::Text("%%");
+            ImGui::TableNextCell();
+            right_aligned_text(HUDElements.colors.text, HUDElements.ralign_width, "%i", int(group.max));
+            ImGui::SameLine(0, 1.0f);
+            ImGui::Text("%%");
+            ImGui::SameLine(0, 1.0f);
+            ImGui::PushFont(HUDElements.sw_stats->font1);
+            ImGui::Text("max");
+            ImGui::PopFont();
+        }
+        return;
+    }
     if (HUDElements.params->enabled[OVERLAY_PARAM_ENABLED_core_load]){
-         int i = 0;
-         for (const CPUData &cpuData : cpuStats.GetCPUData())
+         for (unsigned i = 0; i < HUDElements.telemetry.core_count; i++)
          {
+            const telemetry_core& cpuData = HUDElements.telemetry.cores[i];
             ImGui::TableNextRow();
             ImGui::TextColored(HUDElements.colors.cpu, "CPU");
             ImGui::SameLine(0, 1.0f);
@@ -240,7 +317,6 @@ void HudElements::core_load(){
             ImGui::PushFont(HUDElements.sw_stats->font1);
             ImGui::Text("MHz");
             ImGui::PopFont();
-            i++;
          }
     }
 }
@@ -257,7 +333,7 @@ void HudElements::io_stats(){
 
         if (HUDElements.params->enabled[OVERLAY_PARAM_ENABLED_io_read]){
             ImGui::TableNextCell();
-            float val = HUDElements.sw_stats->io.diff.read * 1000000 / sampling;
+            float val = HUDElements.telemetry.io.diff.read * 1000000 / sampling;
             right_aligned_text(HUDElements.colors.text, HUDElements.ralign_width, val < 100 ? "%.1f" : "%.f", val);
             ImGui::SameLine(0,1.0f);
             ImGui::PushFont(HUDElements.sw_stats->font1);
@@ -266,7 +342,7 @@ void HudElements::io_stats(){
         }
         if (HUDElements.params->enabled[OVERLAY_PARAM_ENABLED_io_write]){
             ImGui::TableNextCell();
-            float val = HUDElements.sw_stats->io.diff.write * 1000000 / sampling;
+            float val = HUDElements.telemetry.io.diff.write * 1000000 / sampling;
             right_aligned_text(HUDElements.colors.text, HUDElements.ralign_width, val < 100 ? "%.1f" : "%.f", val);
             ImGui::SameLine(0,1.0f);
             ImGui::PushFont(HUDElements.sw_stats->font1);
@@ -274,6 +350,42 @@ void HudElements::io_stats(){
             ImGui::PopFont();
         }
     }
+#ifdef __gnu_linux__
+    const disk_sample& disk = HUDElements.telemetry.disk;
+    if (HUDElements.params->enabled[OVERLAY_PARAM_ENABLED_disk_stats] && disk.valid){
+        ImGui::TableNextRow();
+        ImGui::TextColored(HUDElements.colors.io, "DISK");
+        ImGui::TableNextCell();
+        right_aligned_text(HUDElements.colors.text, HUDElements.ralign_width, disk.read < 100 ? "%.1f" : "%.f", disk.read);
+        ImGui::SameLine(0,1.0f);
+        ImGui::PushFont(HUDElements.sw_stats->font1);
+        ImGui::Text("R MiB/s");
+        ImGui::PopFont();
+        ImGui::TableNextCell();
+        right_aligned_text(HUDElements.colors.text, HUDElements.ralign_width, disk.write < 100 ? "%.1f" : "%.f", disk.write);
+        ImGui::SameLine(0,1.0f);
+        ImGui::PushFont(HUDElements.sw_stats->font1);
+        ImGui::Text("W MiB/s");
+        ImGui::PopFont();
+
+        ImGui::TableNextRow();
+        ImGui::PushFont(HUDElements.sw_stats->font1);
+        ImGui::TextColored(HUDElements.colors.io, "%s", HUDElements.telemetry.disk_name);
+        ImGui::PopFont();
+        ImGui::TableNextCell();
+        right_aligned_text(HUDElements.colors.text, HUDElements.ralign_width, "%.f", disk.read_iops + disk.write_iops);
+        ImGui::SameLine(0,1.0f);
+        ImGui::PushFont(HUDElements.sw_stats->font1);
+        ImGui::Text("IOPS");
+        ImGui::PopFont();
+        ImGui::TableNextCell();
+        right_aligned_text(HUDElements.colors.text, HUDElements.ralign_width, "%.1f", disk.latency);
+        ImGui::SameLine(0,1.0f);
+        ImGui::PushFont(HUDElements.sw_stats->font1);
+        ImGui::Text("ms");
+        ImGui::PopFont();
+    }
+#endif
 }
 
 void HudElements::vram(){
@@ -281,19 +393,32 @@ void HudElements::vram(){
         ImGui::TableNextRow();
         ImGui::TextColored(HUDElements.colors.vram, "VRAM");
         ImGui::TableNextCell();
-        right_aligned_text(HUDElements.colors.text, HUDElements.ralign_width, "%.1f", gpu_info.memoryUsed);
+        right_aligned_text(HUDElements.colors.text, HUDElements.ralign_width, "%.1f", HUDElements.telemetry.gpu.memoryUsed);
         ImGui::SameLine(0,1.0f);
         ImGui::PushFont(HUDElements.sw_stats->font1);
         ImGui::Text("GiB");
         ImGui::PopFont();
         if (HUDElements.params->enabled[OVERLAY_PARAM_ENABLED_gpu_mem_clock]){
             ImGui::TableNextCell();
-            right_aligned_text(HUDElements.colors.text, HUDElements.ralign_width, "%i", gpu_info.MemClock);
+            right_aligned_text(HUDElements.colors.text, HUDElements.ralign_width, "%i", HUDElements.telemetry.gpu.MemClock);
             ImGui::SameLine(0, 1.0f);
             ImGui::PushFont(HUDElements.sw_stats->font1);
             ImGui::Text("MHz");
             ImGui::PopFont();
         }
+        const gpuProcInfo& proc = HUDElements.telemetry.gpu_proc;
+        if (HUDElements.params->enabled[OVERLAY_PARAM_ENABLED_proc_gpu_stats] && proc.valid){
+            ImGui::TableNextRow();
+            ImGui::PushFont(HUDElements.sw_stats->font1);
+            ImGui::TextColored(HUDElements.colors.vram, "App");
+            ImGui::PopFont();
+            ImGui::TableNextCell();
+            right_aligned_text(HUDElements.colors.text, HUDElements.ralign_width, "%.1f", proc.memoryUsed);
+            ImGui::SameLine(0,1.0f);
+            ImGui::PushFont(HUDElements.sw_stats->font1);
+            ImGui::Text("GiB");
+            ImGui::PopFont();
+        }
     }
 }
 void HudElements::ram(){
@@ -302,7 +427,7 @@ void HudElements::ram(){
          ImGui::TableNextRow();
          ImGui::TextColored(HUDElements.colors.ram, "RAM");
          ImGui::TableNextCell();
-         right_aligned_text(HUDElements.colors.text, HUDElements.ralign_width, "%.1f", memused);
+         right_aligned_text(HUDElements.colors.text, HUDElements.ralign_width, "%.1f", HUDElements.telemetry.ram_used);
          ImGui::SameLine(0,1.0f);
          ImGui::PushFont(HUDElements.sw_stats->font1);
          ImGui::Text("GiB");
@@ -311,6 +436,155 @@ void HudElements::ram(){
 #endif
 }
 
+void HudElements::procmem(){
+#ifdef __gnu_linux__
+    if (HUDElements.params->enabled[OVERLAY_PARAM_ENABLED_procmem]){
+        const log_procmem& t = HUDElements.telemetry.procmem;
+        ImGui::TableNextRow();
+        ImGui::TextColored(HUDElements.colors.ram, "Mem");
+        ImGui::TableNextCell();
+        right_aligned_text(HUDElements.colors.text, HUDElements.ralign_width, "%.2f", t.rss);
+        ImGui::SameLine(0,1.0f);
+        ImGui::PushFont(HUDElements.sw_stats->font1);
+        ImGui::Text("GiB");
+        ImGui::PopFont();
+        ImGui::TableNextCell();
+        right_aligned_text(HUDElements.colors.text, HUDElements.ralign_width, "%.2f", t.pss);
+        ImGui::SameLine(0,1.0f);
+        ImGui::PushFont(HUDElements.sw_stats->font1);
+        ImGui::Text("pss");
+        ImGui::PopFont();
+
+        ImGui::TableNextRow();
+        ImGui::PushFont(HUDElements.sw_stats->font1);
+        ImGui::TextColored(HUDElements.colors.ram, "Swap");
+        ImGui::PopFont();
+        ImGui::TableNextCell();
+        right_aligned_text(HUDElements.colors.text, HUDElements.ralign_width, "%.2f", t.swap);
+        ImGui::SameLine(0,1.0f);
+        ImGui::PushFont(HUDElements.sw_stats->font1);
+        ImGui::Text("GiB");
+        ImGui::PopFont();
+        ImGui::TableNextCell();
+        right_aligned_text(HUDElements.colors.text, HUDElements.ralign_width, "%+.1f", t.growth);
+        ImGui::SameLine(0,1.0f);
+        ImGui::PushFont(HUDElements.sw_stats->font1);
+        ImGui::Text("MiB/s");
+        ImGui::PopFont();
+    }
+#endif
+}
+
+// avg10 of the processes waiting on the resource, some and all of them
+void HudElements::psi(){
+#ifdef __gnu_linux__
+    if (HUDElements.params->enabled[OVERLAY_PARAM_ENABLED_psi]){
+        static const char *labels[PSI_MAX] = { "PSI CPU", "PSI IO", "PSI MEM" };
+        for (int r = 0; r < PSI_MAX; r++) {
+            const psi_sample& s = HUDElements.telemetry.psi[r];
+            if (!s.valid)
+                continue;
+            ImGui::TableNextRow();
+            ImGui::TextColored(HUDElements.colors.engine, "%s", labels[r]);
+            ImGui::TableNextCell();
+            right_aligned_text(HUDElements.colors.text, HUDElements.ralign_width, "%.1f", s.some.avg10);
+            ImGui::SameLine(0, 1.0f);
+            ImGui::PushFont(HUDElements.sw_stats->font1);
+            ImGui::Text("some");
+            ImGui::PopFont();
+            ImGui::TableNextCell();
+            right_aligned_text(HUDElements.colors.text, HUDElements.ralign_width, "%.1f", s.full.avg10);
+            ImGui::SameLine(0, 1.0f);
+            ImGui::PushFont(HUDElements.sw_stats->font1);
+            ImGui::Text("full");
+            ImGui::PopFont();
+        }
+    }
+#endif
+}
+
+void HudElements::throttling_status(){
+    if (HUDElements.params->enabled[OVERLAY_PARAM_ENABLED_throttling_status]){
+        const logData& t = HUDElements.telemetry.log;
+        char reasons[32];
+        ImGui::TableNextRow();
+        ImGui::TextColored(HUDElements.colors.engine, "%s", "Throttle");
+        ImGui::TableNextCell();
+        ImGui::PushFont(HUDElements.sw_stats->font1);
+        ImGui::TextColored(HUDElements.colors.gpu, "%s", "GPU");
+        ImGui::SameLine(0, 3.0f);
+        ImGui::Text("%s", t.gpu_throttle ? throttle_reason_string(t.gpu_throttle, reasons, sizeof(reasons)) : "-");
+        ImGui::TableNextCell();
+        ImGui::TextColored(HUDElements.colors.cpu, "%s", "CPU");
+        ImGui::SameLine(0, 3.0f);
+        ImGui::Text("%s", t.cpu_throttle ? throttle_reason_string(t.cpu_throttle, reasons, sizeof(reasons)) : "-");
+        ImGui::PopFont();
+    }
+}
+
+void HudElements::cstates(){
+#ifdef __gnu_linux__
+    const cpuidle_sample& idle = HUDElements.telemetry.cstates;
+    if (HUDElements.params->enabled[OVERLAY_PARAM_ENABLED_cstates] && idle.valid){
+        auto text_color = HUDElements.colors.text;
+        for (unsigned i = 0; i < idle.count; i++) {
+            ImGui::TableNextRow();
+            ImGui::TextColored(HUDElements.colors.cpu, "%s", HUDElements.telemetry.cstate_names[i]);
+            ImGui::TableNextCell();
+            right_aligned_text(text_color, HUDElements.ralign_width, "%.f", idle.residency[i]);
+            ImGui::SameLine(0, 1.0f);
+            ImGui::Text("%%");
+            ImGui::TableNextCell();
+            right_aligned_text(text_color, HUDElements.ralign_width, "%.f", idle.rate[i]);
+            ImGui::SameLine(0, 1.0f);
+            ImGui::PushFont(HUDElements.sw_stats->font1);
+            ImGui::Text("/s");
+            ImGui::PopFont();
+        }
+        // deepest state and wakeups of every core, next to core_load's rows
+        if (!HUDElements.params->enabled[OVERLAY_PARAM_ENABLED_core_load])
+            return;
+        for (unsigned i = 0; i < HUDElements.telemetry.core_count; i++) {
+            const telemetry_core& core = HUDElements.telemetry.cores[i];
+            ImGui::TableNextRow();
+            ImGui::TextColored(HUDElements.colors.cpu, "Idle");
+            ImGui::SameLine(0, 1.0f);
+            ImGui::PushFont(HUDElements.sw_stats->font1);
+            ImGui::TextColored(HUDElements.colors.cpu, "%i", i);
+            ImGui::PopFont();
+            ImGui::TableNextCell();
+            right_aligned_text(text_color, HUDElements.ralign_width, "%.f", core.idle_deepest);
+            ImGui::SameLine(0, 1.0f);
+            ImGui::Text("%%");
+            ImGui::TableNextCell();
+            right_aligned_text(text_color, HUDElements.ralign_width, "%.f", core.idle_rate);
+            ImGui::SameLine(0, 1.0f);
+            ImGui::PushFont(HUDElements.sw_stats->font1);
+            ImGui::Text("/s");
+            ImGui::PopFont();
+        }
+    }
+#endif
+}
+
+void HudElements::cpu_power_domains(){
+    if (HUDElements.params->enabled[OVERLAY_PARAM_ENABLED_cpu_power_domains]){
+        const telemetry_snapshot& t = HUDElements.telemetry;
+        for (unsigned i = 0; i < t.rapl_domain_count; i++) {
+            ImGui::TableNextRow();
+            ImGui::PushFont(HUDElements.sw_stats->font1);
+            ImGui::TextColored(HUDElements.colors.cpu, "%s", t.rapl_domains[i].name);
+            ImGui::PopFont();
+            ImGui::TableNextCell();
+            right_aligned_text(HUDElements.colors.text, HUDElements.ralign_width, "%.1f", t.rapl_domains[i].power);
+            ImGui::SameLine(0, 1.0f);
+            ImGui::PushFont(HUDElements.sw_stats->font1);
+            ImGui::Text("W");
+            ImGui::PopFont();
+        }
+    }
+}
+
 void HudElements::fps(){
 if (HUDElements.params->enabled[OVERLAY_PARAM_ENABLED_fps]){
         ImGui::TableNextRow();
@@ -332,6 +606,14 @@ if (HUDElements.params->enabled[OVERLAY_PARAM_ENABLED_fps]){
             ImGui::Text("ms");
             ImGui::PopFont();
         }
+        if (HUDElements.params->enabled[OVERLAY_PARAM_ENABLED_runqueue_wait]){
+            ImGui::TableNextCell();
+            right_aligned_text(HUDElements.colors.text, HUDElements.ralign_width, "%.2f", HUDElements.sw_stats->runqueue_wait);
+            ImGui::SameLine(0, 1.0f);
+            ImGui::PushFont(HUDElements.sw_stats->font1);
+            ImGui::Text("wait");
+            ImGui::PopFont();
+        }
     }
 }
 
@@ -458,6 +740,8 @@ void HudElements::graphs(){
     ImGui::Dummy(ImVec2(0.0f, real_font_size.y));
     std::string value = HUDElements.ordered_functions[HUDElements.place].second;
     std::vector<float> arr(50, 0);
+    // the driver's samples show the short bursts the polled values average out
+    bool samples = HUDElements.params->enabled[OVERLAY_PARAM_ENABLED_nvml_samples] && !gpu_sample_data.empty();
 
     ImGui::PushFont(HUDElements.sw_stats->font1);
     if (value == "cpu_load"){
@@ -470,9 +754,16 @@ void HudElements::graphs(){
     }
 
     if (value == "gpu_load"){
-        for (auto& it : graph_data){
-            arr.push_back(float(it.gpu_load));
-            arr.erase(arr.begin());
+        if (samples) {
+            for (auto& it : gpu_sample_data){
+                arr.push_back(float(it.load));
+                arr.erase(arr.begin());
+            }
+        } else {
+            for (auto& it : graph_data){
+                arr.push_back(float(it.gpu_load));
+                arr.erase(arr.begin());
+            }
         }
         HUDElements.max = 100; HUDElements.min = 0;
         ImGui::TextColored(HUDElements.colors.engine, "%s", "GPU Load");
@@ -505,9 +796,16 @@ void HudElements::graphs(){
     }
 
     if (value == "gpu_core_clock"){
-        for (auto& it : graph_data){
-            arr.push_back(float(it.gpu_core_clock));
-            arr.erase(arr.begin());
+        if (samples) {
+            for (auto& it : gpu_sample_data){
+                arr.push_back(float(it.CoreClock));
+                arr.erase(arr.begin());
+            }
+        } else {
+            for (auto& it : graph_data){
+                arr.push_back(float(it.gpu_core_clock));
+                arr.erase(arr.begin());
+            }
         }
         if (int(arr.back()) > HUDElements.gpu_core_max)
             HUDElements.gpu_core_max = arr.back();
@@ -518,9 +816,16 @@ void HudElements::graphs(){
     }
 
     if (value == "gpu_mem_clock"){
-        for (auto& it : graph_data){
-            arr.push_back(float(it.gpu_mem_clock));
-            arr.erase(arr.begin());
+        if (samples) {
+            for (auto& it : gpu_sample_data){
+                arr.push_back(float(it.MemClock));
+                arr.erase(arr.begin());
+            }
+        } else {
+            for (auto& it : graph_data){
+                arr.push_back(float(it.gpu_mem_clock));
+                arr.erase(arr.begin());
+            }
         }
         if (int(arr.back()) > HUDElements.gpu_mem_max)
             HUDElements.gpu_mem_max = arr.back();
@@ -536,7 +841,7 @@ void HudElements::graphs(){
             arr.erase(arr.begin());
         }
 
-        HUDElements.max = gpu_info.memoryTotal;
+        HUDElements.max = HUDElements.telemetry.gpu.memoryTotal;
         HUDElements.min = 0;
         ImGui::TextColored(HUDElements.colors.engine, "%s", "VRAM");
     }
@@ -549,10 +854,27 @@ void HudElements::graphs(){
             arr.erase(arr.begin());
         }
 
-        HUDElements.max = memmax;
+        HUDElements.max = HUDElements.telemetry.ram_total;
         HUDElements.min = 0;
         ImGui::TextColored(HUDElements.colors.engine, "%s", "RAM");
     }
+
+#ifdef __gnu_linux__
+    for (int r = 0; r < PSI_MAX; r++) {
+        if (value != std::string("psi_") + psi_resource_names[r])
+            continue;
+        if (!HUDElements.params->enabled[OVERLAY_PARAM_ENABLED_psi])
+            HUDElements.params->enabled[OVERLAY_PARAM_ENABLED_psi] = true;
+        for (float avg10 : psi_graph_data[r]){
+            arr.push_back(avg10);
+            arr.erase(arr.begin());
+        }
+
+        HUDElements.max = 100;
+        HUDElements.min = 0;
+        ImGui::TextColored(HUDElements.colors.engine, "PSI %s", psi_resource_names[r]);
+    }
+#endif
     ImGui::PopFont();
     ImGui::Dummy(ImVec2(0.0f,5.0f));
     ImGui::PushStyleColor(ImGuiCol_FrameBg, ImVec4(0.0f, 0.0f, 0.0f, 0.0f));
@@ -572,6 +894,79 @@ void HudElements::graphs(){
     ImGui::PopStyleColor(1);
 }
 
+static void sampler_cost_row(const char *name, const telemetry_cost& cost, bool small){
+    ImGui::TableNextRow();
+    if (small)
+        ImGui::PushFont(HUDElements.sw_stats->font1);
+    ImGui::TextColored(HUDElements.colors.engine, "%s", name);
+    if (small)
+        ImGui::PopFont();
+    ImGui::TableNextCell();
+    right_aligned_text(HUDElements.colors.text, HUDElements.ralign_width, "%.0f", cost.avg);
+    ImGui::SameLine(0, 1.0f);
+    ImGui::PushFont(HUDElements.sw_stats->font1);
+    ImGui::Text("µs");
+    ImGui::PopFont();
+    ImGui::TableNextCell();
+    right_aligned_text(HUDElements.colors.text, HUDElements.ralign_width, "%.0f", cost.max);
+    ImGui::SameLine(0, 1.0f);
+    ImGui::PushFont(HUDElements.sw_stats->font1);
+    ImGui::Text("max");
+    ImGui::PopFont();
+}
+
+void HudElements::sampler_stats(){
+    if (HUDElements.params->enabled[OVERLAY_PARAM_ENABLED_sampler_stats]){
+        const telemetry_snapshot& t = HUDElements.telemetry;
+        sampler_cost_row("Sampler", t.pass_cost, false);
+        // batched reads of the last pass, without io_uring there are none
+        if (t.sampler_reads) {
+            ImGui::TableNextRow();
+            ImGui::PushFont(HUDElements.sw_stats->font1);
+            ImGui::TextColored(HUDElements.colors.engine, "%s", "reads");
+            ImGui::PopFont();
+            ImGui::TableNextCell();
+            right_aligned_text(HUDElements.colors.text, HUDElements.ralign_width, "%u", t.sampler_reads);
+            ImGui::TableNextCell();
+            right_aligned_text(HUDElements.colors.text, HUDElements.ralign_width, "%u", t.sampler_syscalls);
+            ImGui::SameLine(0, 1.0f);
+            ImGui::PushFont(HUDElements.sw_stats->font1);
+            ImGui::Text("calls");
+            ImGui::PopFont();
+        }
+        for (unsigned i = 0; i < t.cost_count; i++) {
+            // sources that never ran
+            if (t.costs[i].max > 0)
+                sampler_cost_row(t.costs[i].name, t.costs[i], true);
+        }
+    }
+}
+
+void HudElements::thread_load(){
+    if (HUDElements.params->enabled[OVERLAY_PARAM_ENABLED_thread_load]){
+        const telemetry_snapshot& t = HUDElements.telemetry;
+        for (unsigned i = 0; i < t.thread_count; i++) {
+            const top_thread& thread = t.threads[i];
+            ImGui::TableNextRow();
+            ImGui::PushFont(HUDElements.sw_stats->font1);
+            ImGui::TextColored(HUDElements.colors.cpu, "%s", thread.name);
+            ImGui::PopFont();
+            ImGui::TableNextCell();
+            right_aligned_text(HUDElements.colors.text, HUDElements.ralign_width, "%.0f", thread.percent);
+            ImGui::SameLine(0, 1.0f);
+            ImGui::Text("%%");
+            if (thread.count > 1) {
+                ImGui::TableNextCell();
+                right_aligned_text(HUDElements.colors.text, HUDElements.ralign_width, "%u", thread.count);
+                ImGui::SameLine(0, 1.0f);
+                ImGui::PushFont(HUDElements.sw_stats->font1);
+                ImGui::Text("thr");
+                ImGui::PopFont();
+            }
+        }
+    }
+}
+
 void HudElements::sort_elements(std::pair<std::string, std::string> option){
     auto param = option.first;
     auto value = option.second;
@@ -592,6 +987,13 @@ void HudElements::sort_elements(std::pair<std::string, std::string> option){
     if (param == "wine")            { ordered_functions.push_back({wine, value});           }
     if (param == "frame_timing")    { ordered_functions.push_back({frame_timing, value});   }
     if (param == "media_player")    { ordered_functions.push_back({media_player, value});   }
+    if (param == "sampler_stats")   { ordered_functions.push_back({sampler_stats, value});  }
+    if (param == "thread_load")     { ordered_functions.push_back({thread_load, value});    }
+    if (param == "procmem")         { ordered_functions.push_back({procmem, value});        }
+    if (param == "psi")             { ordered_functions.push_back({psi, value});            }
+    if (param == "throttling_status") { ordered_functions.push_back({throttling_status, value}); }
+    if (param == "cstates")         { ordered_functions.push_back({cstates, value});        }
+    if (param == "cpu_power_domains") { ordered_functions.push_back({cpu_power_domains, value}); }
     if (param == "graphs"){
         if (!HUDElements.params->enabled[OVERLAY_PARAM_ENABLED_graphs])
             HUDElements.params->enabled[OVERLAY_PARAM_ENABLED_graphs] = true;
@@ -617,6 +1019,11 @@ void HudElements::legacy_elements(){
     ordered_functions.push_back({io_stats,           value});
     ordered_functions.push_back({vram,               value});
     ordered_functions.push_back({ram,                value});
+    ordered_functions.push_back({procmem,            value});
+    ordered_functions.push_back({psi,                value});
+    ordered_functions.push_back({throttling_status,  value});
+    ordered_functions.push_back({cstates,            value});
+    ordered_functions.push_back({cpu_power_domains,  value});
     ordered_functions.push_back({fps,                value});
     ordered_functions.push_back({engine_version,     value});
     ordered_functions.push_back({gpu_name,           value});
@@ -625,6 +1032,8 @@ void HudElements::legacy_elements(){
     ordered_functions.push_back({wine,               value});
     ordered_functions.push_back({frame_timing,       value});
     ordered_functions.push_back({media_player,       value});
+    ordered_functions.push_back({sampler_stats,      value});
+    ordered_functions.push_back({thread_load,        value});
 }
 
 HudElements HUDElements;
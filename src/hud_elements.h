@@ -1,6 +1,7 @@
 #pragma once
 #include "overlay.h"
 #include "overlay_params.h"
+#include "telemetry.h"
 #include <functional>
 #include <map>
 #include <sstream>
@@ -16,9 +17,13 @@ class HudElements{
         std::vector<std::pair<std::string, std::string>> options;
         std::vector<std::pair<void(*)(), std::string >> ordered_functions;
         int min, max, gpu_core_max, gpu_mem_max, cpu_temp_max, gpu_temp_max;
+        // render thread copy of the sampler results, refreshed in update_hud_info
+        telemetry_snapshot telemetry;
+        uint64_t telemetry_version;
         std::vector<std::string> permitted_params = {
             "gpu_load", "cpu_load", "gpu_core_clock", "gpu_mem_clock",
-            "vram", "ram", "cpu_temp", "gpu_temp"
+            "vram", "ram", "cpu_temp", "gpu_temp",
+            "psi_cpu", "psi_io", "psi_memory"
         };
         void sort_elements(std::pair<std::string, std::string> option);
         void legacy_elements();
@@ -30,6 +35,11 @@ class HudElements{
         static void io_stats();
         static void vram();
         static void ram();
+        static void procmem();
+        static void psi();
+        static void throttling_status();
+        static void cstates();
+        static void cpu_power_domains();
         static void fps();
         static void engine_version();
         static void gpu_name();
@@ -39,6 +49,8 @@ class HudElements{
         static void frame_timing();
         static void media_player();
         static void graphs();
+        static void sampler_stats();
+        static void thread_load();
 
         void convert_colors(struct overlay_params& params);
         void convert_colors(bool do_conv, struct overlay_params& params);
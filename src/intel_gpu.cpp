@@ -0,0 +1,442 @@
+#include "intel_gpu.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include "gpu.h"
+#include "gpu_backend.h"
+#include "file_utils.h"
+#include "string_utils.h"
+#include "sensors.h"
+#include "overlay_params.h"
+#include "mesa/util/os_time.h"
+
+/* The parts of include/uapi/drm/i915_drm.h and xe_drm.h the memory region
+ * queries use, libdrm's headers are not a build dependency. */
+
+struct i915_query_item {
+    uint64_t query_id;
+    int32_t length;
+    uint32_t flags;
+    uint64_t data_ptr;
+};
+
+struct i915_query {
+    uint32_t num_items;
+    uint32_t flags;
+    uint64_t items_ptr;
+};
+
+struct i915_memory_region_info {
+    uint16_t memory_class;
+    uint16_t memory_instance;
+    uint32_t rsvd0;
+    uint64_t probed_size;
+    // equals probed_size without CAP_PERFMON
+    uint64_t unallocated_size;
+    uint64_t rsvd1[8];
+};
+
+struct i915_query_memory_regions {
+    uint32_t num_regions;
+    uint32_t rsvd[3];
+    // struct i915_memory_region_info regions[num_regions]
+};
+
+#define I915_QUERY_MEMORY_REGIONS   4
+#define I915_MEMORY_CLASS_DEVICE    1
+#define I915_IOCTL_QUERY            _IOWR('d', 0x40 + 0x39, struct i915_query)
+
+struct xe_device_query {
+    uint64_t extensions;
+    uint32_t query;
+    uint32_t size;
+    uint64_t data;
+    uint64_t reserved[2];
+};
+
+struct xe_mem_region {
+    uint16_t mem_class;
+    uint16_t instance;
+    uint32_t min_page_size;
+    uint64_t total_size;
+    // 0 without CAP_PERFMON
+    uint64_t used;
+    uint64_t cpu_visible_size;
+    uint64_t cpu_visible_used;
+    uint64_t reserved[6];
+};
+
+struct xe_query_mem_regions {
+    uint32_t num_mem_regions;
+    uint32_t pad;
+    // struct xe_mem_region mem_regions[num_mem_regions]
+};
+
+#define XE_DEVICE_QUERY_MEM_REGIONS 1
+#define XE_MEM_REGION_CLASS_VRAM    1
+#define XE_IOCTL_DEVICE_QUERY       _IOWR('d', 0x40 + 0x00, struct xe_device_query)
+
+#define INTEL_PMU_ROOT "/sys/bus/event_source/devices"
+
+intel_gpu::~intel_gpu()
+{
+    for (int fd : m_pmuFds)
+        close(fd);
+    if (m_renderFd >= 0)
+        close(m_renderFd);
+}
+
+bool intel_gpu::init(const intel_gpu_files& files)
+{
+    if (!files.freq.empty())
+        m_freq = m_counters.add(files.freq);
+    if (!files.temp.empty())
+        m_temp = m_counters.add(files.temp);
+    if (!files.energy.empty())
+        m_energy = m_counters.add(files.energy);
+    m_energyRange = files.energy_range;
+    return m_freq >= 0 || m_temp >= 0 || m_energy >= 0;
+}
+
+// "config=0x100002" on i915, "event=0x01,gt=?" on xe. Terms other than
+// config go where format/<term> says, ? parameters are left at 0.
+static bool parse_event_config(const std::string& dir, const std::string& spec, uint64_t& config)
+{
+    std::stringstream terms(spec);
+    std::string term;
+    config = 0;
+    while (std::getline(terms, term, ',')) {
+        auto eq = term.find('=');
+        std::string key = term.substr(0, eq);
+        uint64_t value = eq == std::string::npos ? 1 : strtoull(term.c_str() + eq + 1, nullptr, 0);
+        if (key == "config") {
+            config |= value;
+            continue;
+        }
+
+        // "config:0-7", terms in config1 or config2 are not used by these PMUs
+        unsigned lo, hi;
+        int n = sscanf(read_line(dir + "/format/" + key).c_str(), "config:%u-%u", &lo, &hi);
+        if (n < 1)
+            return false;
+        if (n == 1)
+            hi = lo;
+        uint64_t mask = hi - lo >= 63 ? ~0ull : (1ull << (hi - lo + 1)) - 1;
+        config |= (value & mask) << lo;
+    }
+    return true;
+}
+
+bool intel_gpu::open_event(const std::string& dir, const std::string& name, int cpu, uint32_t type)
+{
+    uint64_t config;
+    std::string spec = read_line(dir + "/events/" + name);
+    if (spec.empty() || !parse_event_config(dir, spec, config))
+        return false;
+
+    struct perf_event_attr attr {};
+    attr.type = type;
+    attr.size = sizeof(attr);
+    attr.config = config;
+    attr.read_format = PERF_FORMAT_GROUP;
+    int group = m_pmuFds.empty() ? -1 : m_pmuFds[0];
+    int fd = syscall(SYS_perf_event_open, &attr, -1, cpu, group, PERF_FLAG_FD_CLOEXEC);
+    if (fd < 0)
+        return false;
+    m_pmuFds.push_back(fd);
+    return true;
+}
+
+// i915 counts in ns, xe's gt-c6-residency in ms
+static uint64_t event_ns_per_unit(const std::string& dir, const std::string& name)
+{
+    std::string unit = read_line(dir + "/events/" + name + ".unit");
+    trim(unit);
+    if (unit == "ms")
+        return 1000000;
+    if (unit == "us")
+        return 1000;
+    return 1;
+}
+
+bool intel_gpu::init_pmu(const std::string& pmu_root, const std::string& pmu)
+{
+    std::string dir = pmu_root + "/" + pmu;
+    std::string type = read_line(dir + "/type");
+    if (type.empty())
+        return false;
+    // uncore PMU, counted system wide on the first CPU of its mask
+    int cpu = atoi(read_line(dir + "/cpumask").c_str());
+
+    // rcs0-busy, bcs0-busy, vcs0-busy... i915 only, xe has ticks per engine
+    // class that need the engine list of the GT
+    auto events = ls((dir + "/events/").c_str(), nullptr, LS_FILES);
+    std::sort(events.begin(), events.end());
+    for (auto& event : events) {
+        if (!ends_with(event, "-busy"))
+            continue;
+        if (open_event(dir, event, cpu, atoi(type.c_str())))
+            m_busy.push_back({event, event_ns_per_unit(dir, event), 0});
+        else if (errno == EACCES || errno == EPERM)
+            break;
+    }
+    for (const char *event : {"rc6-residency", "rc6-residency-gt0", "gt-c6-residency"}) {
+        if (open_event(dir, event, cpu, atoi(type.c_str()))) {
+            m_idle.push_back({event, event_ns_per_unit(dir, event), 0});
+            break;
+        }
+    }
+
+    if (m_pmuFds.empty()) {
+        std::cerr << "MANGOHUD: Can't open the " << pmu << " PMU, no Intel GPU load. "
+                  << "It needs perf_event_paranoid <= 0 or CAP_PERFMON\n";
+        return false;
+    }
+    // nr, then the values in the order the events were opened
+    m_pmuBuf.resize(1 + m_pmuFds.size());
+    return true;
+}
+
+void intel_gpu::update_pmu(gpuInfo& info, uint64_t now)
+{
+    ssize_t size = m_pmuBuf.size() * sizeof(m_pmuBuf[0]);
+    if (read(m_pmuFds[0], m_pmuBuf.data(), size) != size)
+        return;
+
+    uint64_t elapsed = now - m_lastPmuTime;
+    bool first = m_lastPmuTime == 0;
+    m_lastPmuTime = now;
+
+    // the busiest engine, like gpu_busy_percent on amdgpu
+    const uint64_t *values = &m_pmuBuf[1];
+    float busy = 0.f, idle = 0.f;
+    for (auto& event : m_busy) {
+        uint64_t value = *values++;
+        busy = std::max(busy, (value - event.last) * event.ns_per_unit * 100.f / elapsed);
+        event.last = value;
+    }
+    for (auto& event : m_idle) {
+        uint64_t value = *values++;
+        idle = (value - event.last) * event.ns_per_unit * 100.f / elapsed;
+        event.last = value;
+    }
+    if (first || !elapsed)
+        return;
+
+    // time out of RC6 when the engines can't be counted
+    if (!m_busy.empty())
+        info.load = std::min(100.f, busy) + 0.5f;
+    else
+        info.load = 100.f - std::min(100.f, idle) + 0.5f;
+}
+
+bool intel_gpu::init_vram(const std::string& render_node, const std::string& driver)
+{
+    m_xe = driver == "xe";
+    int fd = open(render_node.c_str(), O_RDWR | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+
+    // without a buffer the kernel returns the size it needs
+    int64_t size = 0;
+    if (m_xe) {
+        struct xe_device_query query {};
+        query.query = XE_DEVICE_QUERY_MEM_REGIONS;
+        if (!ioctl(fd, XE_IOCTL_DEVICE_QUERY, &query))
+            size = query.size;
+    } else {
+        struct i915_query_item item {};
+        item.query_id = I915_QUERY_MEMORY_REGIONS;
+        struct i915_query query {};
+        query.num_items = 1;
+        query.items_ptr = (uintptr_t)&item;
+        if (!ioctl(fd, I915_IOCTL_QUERY, &query))
+            size = item.length;
+    }
+    if (size <= 0) {
+        close(fd);
+        return false;
+    }
+    m_queryBuf.resize(size);
+    m_renderFd = fd;
+
+    // integrated GPUs only have system memory
+    gpuInfo info {};
+    update_vram(info);
+    if (info.memoryTotal <= 0.f) {
+        close(m_renderFd);
+        m_renderFd = -1;
+        return false;
+    }
+    return true;
+}
+
+void intel_gpu::update_vram(gpuInfo& info)
+{
+    uint64_t total = 0, used = 0;
+    if (m_xe) {
+        struct xe_device_query query {};
+        query.query = XE_DEVICE_QUERY_MEM_REGIONS;
+        query.size = m_queryBuf.size();
+        query.data = (uintptr_t)m_queryBuf.data();
+        if (ioctl(m_renderFd, XE_IOCTL_DEVICE_QUERY, &query))
+            return;
+
+        auto *header = (const xe_query_mem_regions *)m_queryBuf.data();
+        auto *regions = (const xe_mem_region *)(header + 1);
+        for (uint32_t i = 0; i < header->num_mem_regions; i++) {
+            if (regions[i].mem_class != XE_MEM_REGION_CLASS_VRAM)
+                continue;
+            total += regions[i].total_size;
+            used += regions[i].used;
+        }
+    } else {
+        struct i915_query_item item {};
+        item.query_id = I915_QUERY_MEMORY_REGIONS;
+        item.length = m_queryBuf.size();
+        item.data_ptr = (uintptr_t)m_queryBuf.data();
+        struct i915_query query {};
+        query.num_items = 1;
+        query.items_ptr = (uintptr_t)&item;
+        if (ioctl(m_renderFd, I915_IOCTL_QUERY, &query) || item.length <= 0)
+            return;
+
+        auto *header = (const i915_query_memory_regions *)m_queryBuf.data();
+        auto *regions = (const i915_memory_region_info *)(header + 1);
+        for (uint32_t i = 0; i < header->num_regions; i++) {
+            if (regions[i].memory_class != I915_MEMORY_CLASS_DEVICE)
+                continue;
+            total += regions[i].probed_size;
+            used += regions[i].probed_size - regions[i].unallocated_size;
+        }
+    }
+    info.memoryTotal = float(total) / (1024 * 1024 * 1024);
+    info.memoryUsed = float(used) / (1024 * 1024 * 1024);
+}
+
+bool intel_gpu::update(gpuInfo& info)
+{
+    m_counters.update();
+    uint64_t now = os_time_get_nano();
+    int64_t value;
+
+    if (m_freq >= 0 && m_counters.get(m_freq, value))
+        info.CoreClock = value;
+
+    if (m_temp >= 0 && m_counters.get(m_temp, value))
+        info.temp = value / 1000;
+
+    if (m_energy >= 0 && m_counters.get(m_energy, value)) {
+        uint64_t energy = value;
+        uint64_t delta = 0;
+        if (energy >= m_lastEnergy)
+            delta = energy - m_lastEnergy;
+        else if (m_energyRange)
+            delta = energy + m_energyRange - m_lastEnergy;
+        // uJ per ns to W
+        if (m_lastTime && now > m_lastTime)
+            info.powerUsage = delta * 1000 / (now - m_lastTime);
+        m_lastEnergy = energy;
+        m_lastTime = now;
+    }
+
+    if (!m_pmuFds.empty())
+        update_pmu(info, now);
+    if (m_renderFd >= 0)
+        update_vram(info);
+    return true;
+}
+
+class intel_backend : public gpu_backend
+{
+public:
+    intel_backend(uint32_t device_id, const std::string& pci_dev, const std::string& driver)
+        : gpu_backend(0x8086, device_id, pci_dev), m_driver(driver) {}
+
+    const char *name() const override { return m_driver.c_str(); }
+    bool update(gpuInfo& info) override { return gpu.update(info); }
+    void queue(io_uring_reader& reader) override { gpu.queue(reader); }
+
+    intel_gpu gpu;
+
+private:
+    std::string m_driver;
+};
+
+static std::string first_existing(const std::string& dir, std::initializer_list<const char *> files)
+{
+    for (const char *file : files)
+        if (file_exists(dir + file))
+            return dir + file;
+    return std::string();
+}
+
+// every card of the i915 and xe drivers under /sys/class/drm
+void probe_intel(const overlay_params& params, gpu_backend_list& devices)
+{
+    sensors.init(params.enabled[OVERLAY_PARAM_ENABLED_sensor_cache]);
+    for (auto& card : sensors.chips()) {
+        if (card.cls != SENSOR_DRM)
+            continue;
+        std::string path = card.path + "/device";
+        std::string vendor = read_line(path + "/vendor");
+        trim(vendor);
+        if (vendor != "0x8086")
+            continue;
+        std::string driver = read_symlink((path + "/driver").c_str());
+        driver = driver.substr(driver.find_last_of('/') + 1);
+        if (driver != "i915" && driver != "xe")
+            continue;
+
+        std::string pci_dev = read_symlink(path.c_str());
+        pci_dev = pci_dev.substr(pci_dev.find_last_of('/') + 1);
+        uint32_t device_id = strtol(read_line(path + "/device").c_str(), NULL, 16);
+        auto dev = std::make_unique<intel_backend>(device_id, pci_dev, driver);
+
+        // the actual frequency is 0 while in RC6, the requested one isn't
+        intel_gpu_files files;
+        files.freq = first_existing(card.path, {"/gt_act_freq_mhz", "/gt_cur_freq_mhz",
+                                                "/device/tile0/gt0/freq0/act_freq",
+                                                "/device/tile0/gt0/freq0/cur_freq"});
+        // discrete cards, xe labels its sensors
+        const sensor_chip *hwmon = sensors.find_device(SENSOR_HWMON, card.device);
+        if (hwmon) {
+            if (!sensors.find_input(*hwmon, "temp", "pkg", files.temp))
+                sensors.first_input(*hwmon, "temp", files.temp);
+            if (!sensors.find_input(*hwmon, "energy", "card", files.energy))
+                sensors.first_input(*hwmon, "energy", files.energy);
+        }
+        // integrated ones draw from the uncore RAPL domain
+        const sensor_chip *uncore = sensors.find(SENSOR_POWERCAP, "uncore");
+        if (files.energy.empty() && uncore && file_exists(uncore->path + "/energy_uj")) {
+            files.energy = uncore->path + "/energy_uj";
+            files.energy_range = strtoull(read_line(uncore->path + "/max_energy_range_uj").c_str(), nullptr, 10);
+        }
+
+        // i915_0000_03_00.0 for discrete cards and every xe one, i915 for the iGPU
+        std::string pmu = driver + "_" + pci_dev;
+        std::replace(pmu.begin(), pmu.end(), ':', '_');
+        if (!file_exists(INTEL_PMU_ROOT "/" + pmu))
+            pmu = driver;
+        bool pmu_ok = dev->gpu.init_pmu(INTEL_PMU_ROOT, pmu);
+
+        for (auto& node : ls((path + "/drm/").c_str(), "renderD")) {
+            dev->gpu.init_vram("/dev/dri/" + node, driver);
+            break;
+        }
+
+        if (!dev->gpu.init(files) && !pmu_ok)
+            continue;
+#ifndef NDEBUG
+        std::cerr << "using " << driver << " path: " << path << std::endl;
+#endif
+        devices.push_back(std::move(dev));
+    }
+}
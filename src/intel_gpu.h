@@ -0,0 +1,74 @@
+#pragma once
+#ifndef MANGOHUD_INTEL_GPU_H
+#define MANGOHUD_INTEL_GPU_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "sysfs_counters.h"
+
+struct gpuInfo;
+class io_uring_reader;
+
+// Sysfs files of an i915 or xe card, resolved by the probe so the parsing
+// can also be pointed at a recorded tree. Empty when not available.
+struct intel_gpu_files {
+    std::string freq;           // MHz, actual frequency, else the requested one
+    std::string temp;           // m°C
+    std::string energy;         // uJ, hwmon or the powercap uncore domain
+    uint64_t energy_range = 0;  // uJ the energy counter wraps at, 0 if it doesn't
+};
+
+// Load, frequency, power, temperature and VRAM of an Intel GPU. The files
+// are read with the sampler's batch, load comes from the driver's PMU and
+// VRAM from the memory region query of the render node.
+class intel_gpu
+{
+public:
+    ~intel_gpu();
+
+    // false if none of the files could be opened
+    bool init(const intel_gpu_files& files);
+    // Opens the engine busy and RC6 counters of the PMU named pmu under
+    // pmu_root, system wide counters need perf_event_paranoid <= 0 or
+    // CAP_PERFMON
+    bool init_pmu(const std::string& pmu_root, const std::string& pmu);
+    // VRAM of discrete cards, render_node is e.g. /dev/dri/renderD129 and
+    // driver "i915" or "xe". false for integrated ones.
+    bool init_vram(const std::string& render_node, const std::string& driver);
+
+    void queue(io_uring_reader& reader) { m_counters.queue(reader); }
+    bool update(gpuInfo& info);
+
+private:
+    struct pmu_event {
+        std::string name;
+        uint64_t ns_per_unit;
+        uint64_t last;
+    };
+
+    bool open_event(const std::string& dir, const std::string& name, int cpu, uint32_t type);
+    void update_pmu(gpuInfo& info, uint64_t now);
+    void update_vram(gpuInfo& info);
+
+    counter_set m_counters;
+    int m_freq = -1;
+    int m_temp = -1;
+    int m_energy = -1;
+    uint64_t m_energyRange = 0;
+    uint64_t m_lastEnergy = 0;
+    uint64_t m_lastTime = 0;
+
+    // read as one group through the first fd, busy engines then RC6
+    std::vector<int> m_pmuFds;
+    std::vector<pmu_event> m_busy;
+    std::vector<pmu_event> m_idle;
+    std::vector<uint64_t> m_pmuBuf;
+    uint64_t m_lastPmuTime = 0;
+
+    int m_renderFd = -1;
+    bool m_xe = false;
+    std::vector<uint8_t> m_queryBuf;
+};
+
+#endif //MANGOHUD_INTEL_GPU_H
@@ -0,0 +1,241 @@
+#include "io_uring_reader.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <errno.h>
+#include <unistd.h>
+#ifdef HAVE_IO_URING
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#endif
+
+io_uring_reader::~io_uring_reader()
+{
+    shutdown();
+}
+
+#ifdef HAVE_IO_URING
+
+// liburing is deliberately not used, the layer gets loaded into every game
+static int sys_io_uring_setup(unsigned entries, struct io_uring_params *p)
+{
+    return (int) syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int sys_io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags)
+{
+    return (int) syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0);
+}
+
+bool io_uring_reader::init(unsigned entries)
+{
+    if (available())
+        return true;
+
+    struct io_uring_params p {};
+    m_ring_fd = sys_io_uring_setup(entries, &p);
+    if (m_ring_fd < 0) {
+#ifndef NDEBUG
+        std::cerr << "MANGOHUD: io_uring unavailable (" << strerror(errno) << "), using pread\n";
+#endif
+        m_ring_fd = -1;
+        return false;
+    }
+
+    m_sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    m_cq_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP)
+        m_sq_size = m_cq_size = std::max(m_sq_size, m_cq_size);
+
+    m_sq_ptr = mmap(nullptr, m_sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                    m_ring_fd, IORING_OFF_SQ_RING);
+    if (m_sq_ptr == MAP_FAILED) {
+        m_sq_ptr = nullptr;
+        shutdown();
+        return false;
+    }
+
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        m_cq_ptr = m_sq_ptr;
+    } else {
+        m_cq_ptr = mmap(nullptr, m_cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        m_ring_fd, IORING_OFF_CQ_RING);
+        if (m_cq_ptr == MAP_FAILED) {
+            m_cq_ptr = nullptr;
+            shutdown();
+            return false;
+        }
+    }
+
+    m_sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+    m_sqes_ptr = mmap(nullptr, m_sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      m_ring_fd, IORING_OFF_SQES);
+    if (m_sqes_ptr == MAP_FAILED) {
+        m_sqes_ptr = nullptr;
+        shutdown();
+        return false;
+    }
+
+    char *sq = (char *) m_sq_ptr;
+    char *cq = (char *) m_cq_ptr;
+    m_sq_head  = (unsigned *) (sq + p.sq_off.head);
+    m_sq_tail  = (unsigned *) (sq + p.sq_off.tail);
+    m_sq_mask  = (unsigned *) (sq + p.sq_off.ring_mask);
+    m_sq_array = (unsigned *) (sq + p.sq_off.array);
+    m_cq_head  = (unsigned *) (cq + p.cq_off.head);
+    m_cq_tail  = (unsigned *) (cq + p.cq_off.tail);
+    m_cq_mask  = (unsigned *) (cq + p.cq_off.ring_mask);
+    m_cqes     = (struct io_uring_cqe *) (cq + p.cq_off.cqes);
+    m_sqes     = (struct io_uring_sqe *) m_sqes_ptr;
+    m_entries  = p.sq_entries;
+
+    // iovecs must stay put until the batch is flushed
+    m_iovecs.reserve(m_entries);
+    m_results.reserve(m_entries);
+    return true;
+}
+
+void io_uring_reader::shutdown()
+{
+    if (m_sqes_ptr)
+        munmap(m_sqes_ptr, m_sqes_size);
+    if (m_cq_ptr && m_cq_ptr != m_sq_ptr)
+        munmap(m_cq_ptr, m_cq_size);
+    if (m_sq_ptr)
+        munmap(m_sq_ptr, m_sq_size);
+    m_sq_ptr = m_cq_ptr = m_sqes_ptr = nullptr;
+
+    if (m_ring_fd >= 0)
+        close(m_ring_fd);
+    m_ring_fd = -1;
+}
+
+void io_uring_reader::queue(int fd, char *buf, size_t len, ssize_t *result)
+{
+    *result = -1;
+    if (!available() || fd < 0)
+        return;
+
+    if (m_iovecs.size() == m_entries && !flush())
+        return;
+
+    unsigned tail = *m_sq_tail;
+    unsigned index = tail & *m_sq_mask;
+    size_t slot = m_iovecs.size();
+
+    m_iovecs.push_back({buf, len});
+    m_results.push_back(result);
+
+    struct io_uring_sqe *sqe = &m_sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_READV;
+    sqe->fd = fd;
+    sqe->off = 0;
+    sqe->addr = (uint64_t) (uintptr_t) &m_iovecs[slot];
+    sqe->len = 1;
+    sqe->user_data = slot;
+
+    m_sq_array[index] = index;
+    __atomic_store_n(m_sq_tail, tail + 1, __ATOMIC_RELEASE);
+}
+
+bool io_uring_reader::flush()
+{
+    unsigned pending = m_iovecs.size();
+    bool ret = true;
+
+    if (pending) {
+        // The kernel stops at an entry it fails to prepare and leaves the
+        // rest in the ring, those are submitted again. Only what did go out
+        // is waited for.
+        unsigned submitted = 0;
+        while (submitted < pending) {
+            int n = sys_io_uring_enter(m_ring_fd, pending - submitted, pending - submitted, IORING_ENTER_GETEVENTS);
+            m_syscalls++;
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0) {
+                if (n < 0)
+                    std::cerr << "MANGOHUD: io_uring_enter failed: " << strerror(errno) << "\n";
+                ret = false;
+                break;
+            }
+            submitted += n;
+        }
+
+        unsigned head = *m_cq_head;
+        unsigned completed = 0;
+        while (completed < submitted) {
+            unsigned tail = __atomic_load_n(m_cq_tail, __ATOMIC_ACQUIRE);
+            if (head == tail) {
+                // not everything completed yet
+                m_syscalls++;
+                if (sys_io_uring_enter(m_ring_fd, 0, submitted - completed, IORING_ENTER_GETEVENTS) < 0
+                    && errno != EINTR) {
+                    ret = false;
+                    break;
+                }
+                continue;
+            }
+
+            struct io_uring_cqe *cqe = &m_cqes[head & *m_cq_mask];
+            if (cqe->user_data < m_results.size())
+                *m_results[cqe->user_data] = cqe->res;
+            head++;
+            completed++;
+        }
+        __atomic_store_n(m_cq_head, head, __ATOMIC_RELEASE);
+        m_reads += completed;
+    }
+
+    m_iovecs.clear();
+    m_results.clear();
+
+    // Entries left in the ring would point at stale iovecs, give up on
+    // io_uring. Results that never completed stay at -1 so readers fall back
+    // to pread.
+    if (!ret)
+        shutdown();
+    return ret;
+}
+
+bool io_uring_reader::submit()
+{
+    if (!available())
+        return false;
+
+    bool ret = flush();
+    m_last_reads = m_reads;
+    m_last_syscalls = m_syscalls;
+    m_reads = m_syscalls = 0;
+    return ret;
+}
+
+#else
+
+bool io_uring_reader::init(unsigned)
+{
+    return false;
+}
+
+void io_uring_reader::shutdown()
+{
+}
+
+void io_uring_reader::queue(int, char *, size_t, ssize_t *result)
+{
+    *result = -1;
+}
+
+bool io_uring_reader::flush()
+{
+    return false;
+}
+
+bool io_uring_reader::submit()
+{
+    return false;
+}
+
+#endif
@@ -0,0 +1,57 @@
+#pragma once
+#ifndef MANGOHUD_IO_URING_READER_H
+#define MANGOHUD_IO_URING_READER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+// Batches the small telemetry reads of a sampler tick into a single
+// io_uring submission. Without io_uring support (build option or kernel)
+// available() is false and readers keep doing their own pread() calls.
+class io_uring_reader
+{
+public:
+    io_uring_reader() = default;
+    ~io_uring_reader();
+
+    io_uring_reader(const io_uring_reader&) = delete;
+    io_uring_reader& operator=(const io_uring_reader&) = delete;
+
+    bool init(unsigned entries = 256);
+    bool available() const { return m_ring_fd >= 0; }
+
+    // Queues a read of up to len bytes from offset 0 of fd. The result of
+    // the read (bytes or -errno) is stored in *result after submit().
+    void queue(int fd, char *buf, size_t len, ssize_t *result);
+    // Submits everything queued and waits for all of it to complete
+    bool submit();
+
+    // reads and syscalls issued by the last submit()
+    unsigned last_reads() const { return m_last_reads; }
+    unsigned last_syscalls() const { return m_last_syscalls; }
+
+private:
+    bool flush();
+    void shutdown();
+
+    int m_ring_fd = -1;
+
+    void *m_sq_ptr = nullptr, *m_cq_ptr = nullptr, *m_sqes_ptr = nullptr;
+    size_t m_sq_size = 0, m_cq_size = 0, m_sqes_size = 0;
+
+    unsigned *m_sq_head = nullptr, *m_sq_tail = nullptr, *m_sq_mask = nullptr, *m_sq_array = nullptr;
+    unsigned *m_cq_head = nullptr, *m_cq_tail = nullptr, *m_cq_mask = nullptr;
+    struct io_uring_sqe *m_sqes = nullptr;
+    struct io_uring_cqe *m_cqes = nullptr;
+    unsigned m_entries = 0;
+
+    std::vector<struct iovec> m_iovecs;
+    std::vector<ssize_t *> m_results;
+    unsigned m_reads = 0, m_syscalls = 0;
+    unsigned m_last_reads = 0, m_last_syscalls = 0;
+};
+
+#endif //MANGOHUD_IO_URING_READER_H
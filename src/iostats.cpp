@@ -1,23 +1,38 @@
 #include "iostats.h"
-#include "string_utils.h"
-#include <fstream>
+#include "sysfs_counters.h"
+
+static counter_set counters;
+static int self_io = -1;
+
+static void init_io_stats()
+{
+    static bool inited = false;
+    if (!inited) {
+        self_io = counters.add("/proc/self/io", 256);
+        inited = true;
+    }
+}
+
+void queue_io_stats(io_uring_reader& reader) {
+    init_io_stats();
+    counters.queue(reader);
+}
 
 void getIoStats(void *args) {
+    init_io_stats();
+
     iostats *io = reinterpret_cast<iostats *>(args);
     if (io) {
         io->prev.read_bytes  = io->curr.read_bytes;
         io->prev.write_bytes = io->curr.write_bytes;
 
-        std::string line;
-        std::ifstream f("/proc/self/io");
-        while (std::getline(f, line)) {
-            if (starts_with(line, "read_bytes:")) {
-                try_stoull(io->curr.read_bytes, line.substr(12));
-            }
-            else if (starts_with(line, "write_bytes:")) {
-                try_stoull(io->curr.write_bytes, line.substr(13));
-            }
-        }
+        int64_t value;
+        counters.update();
+        if (counters.get(self_io, "read_bytes:", value))
+            io->curr.read_bytes = value;
+        if (counters.get(self_io, "write_bytes:", value))
+            io->curr.write_bytes = value;
+
         io->diff.read  = (io->curr.read_bytes  - io->prev.read_bytes) / (1024.f * 1024.f);
         io->diff.write = (io->curr.write_bytes - io->prev.write_bytes) / (1024.f * 1024.f);
     }
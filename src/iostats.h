@@ -20,6 +20,9 @@ struct iostats {
     } diff;
 };
 
+class io_uring_reader;
+
 void getIoStats(void *args);
+void queue_io_stats(io_uring_reader& reader);
 
 #endif //MANGOHUD_IOSTATS_H
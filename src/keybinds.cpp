@@ -2,6 +2,7 @@
 #include "timing.hpp"
 #include "logging.h"
 #include "keybinds.h"
+#include "sampler.h"
 
 void check_keybinds(struct swapchain_stats& sw_stats, struct overlay_params& params, uint32_t vendorID){
    using namespace std::chrono_literals;
@@ -27,9 +28,7 @@ void check_keybinds(struct swapchain_stats& sw_stats, struct overlay_params& par
          logger->stop_logging();
        } else {
          logger->start_logging();
-         std::thread(update_hw_info, std::ref(sw_stats), std::ref(params),
-                     vendorID)
-             .detach();
+         hw_sampler.update_all();
          benchmark.fps_data.clear();
        }
      }
@@ -200,6 +200,58 @@ bool libnvml_loader::Load(const std::string& library_name) {
     return false;
   }
 
+#if defined(LIBRARY_LOADER_NVML_H_DLOPEN)
+  nvmlDeviceGetProcessUtilization =
+      reinterpret_cast<decltype(this->nvmlDeviceGetProcessUtilization)>(
+          dlsym(library_, "nvmlDeviceGetProcessUtilization"));
+#endif
+#if defined(LIBRARY_LOADER_NVML_H_DT_NEEDED)
+  nvmlDeviceGetProcessUtilization = &::nvmlDeviceGetProcessUtilization;
+#endif
+  if (!nvmlDeviceGetProcessUtilization) {
+    CleanUp(true);
+    return false;
+  }
+
+#if defined(LIBRARY_LOADER_NVML_H_DLOPEN)
+  nvmlDeviceGetGraphicsRunningProcesses =
+      reinterpret_cast<decltype(this->nvmlDeviceGetGraphicsRunningProcesses)>(
+          dlsym(library_, "nvmlDeviceGetGraphicsRunningProcesses"));
+#endif
+#if defined(LIBRARY_LOADER_NVML_H_DT_NEEDED)
+  nvmlDeviceGetGraphicsRunningProcesses = &::nvmlDeviceGetGraphicsRunningProcesses;
+#endif
+  if (!nvmlDeviceGetGraphicsRunningProcesses) {
+    CleanUp(true);
+    return false;
+  }
+
+#if defined(LIBRARY_LOADER_NVML_H_DLOPEN)
+  nvmlDeviceGetCurrentClocksThrottleReasons =
+      reinterpret_cast<decltype(this->nvmlDeviceGetCurrentClocksThrottleReasons)>(
+          dlsym(library_, "nvmlDeviceGetCurrentClocksThrottleReasons"));
+#endif
+#if defined(LIBRARY_LOADER_NVML_H_DT_NEEDED)
+  nvmlDeviceGetCurrentClocksThrottleReasons = &::nvmlDeviceGetCurrentClocksThrottleReasons;
+#endif
+  if (!nvmlDeviceGetCurrentClocksThrottleReasons) {
+    CleanUp(true);
+    return false;
+  }
+
+#if defined(LIBRARY_LOADER_NVML_H_DLOPEN)
+  nvmlDeviceGetSamples =
+      reinterpret_cast<decltype(this->nvmlDeviceGetSamples)>(
+          dlsym(library_, "nvmlDeviceGetSamples"));
+#endif
+#if defined(LIBRARY_LOADER_NVML_H_DT_NEEDED)
+  nvmlDeviceGetSamples = &::nvmlDeviceGetSamples;
+#endif
+  if (!nvmlDeviceGetSamples) {
+    CleanUp(true);
+    return false;
+  }
+
   loaded_ = true;
   return true;
 }
@@ -220,5 +272,9 @@ void libnvml_loader::CleanUp(bool unload) {
   nvmlDeviceGetCount_v2 = NULL;
   nvmlDeviceGetHandleByIndex_v2 = NULL;
   nvmlDeviceGetHandleByPciBusId_v2 = NULL;
+  nvmlDeviceGetProcessUtilization = NULL;
+  nvmlDeviceGetGraphicsRunningProcesses = NULL;
+  nvmlDeviceGetCurrentClocksThrottleReasons = NULL;
+  nvmlDeviceGetSamples = NULL;
 
 }
@@ -37,6 +37,10 @@ class libnvml_loader {
   decltype(&::nvmlDeviceGetClockInfo) nvmlDeviceGetClockInfo;
   decltype(&::nvmlErrorString) nvmlErrorString;
   decltype(&::nvmlDeviceGetPowerUsage) nvmlDeviceGetPowerUsage;
+  decltype(&::nvmlDeviceGetProcessUtilization) nvmlDeviceGetProcessUtilization;
+  decltype(&::nvmlDeviceGetGraphicsRunningProcesses) nvmlDeviceGetGraphicsRunningProcesses;
+  decltype(&::nvmlDeviceGetCurrentClocksThrottleReasons) nvmlDeviceGetCurrentClocksThrottleReasons;
+  decltype(&::nvmlDeviceGetSamples) nvmlDeviceGetSamples;
 
  private:
   void CleanUp(bool unload);
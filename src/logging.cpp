@@ -1,6 +1,10 @@
 #include "logging.h"
 #include "overlay.h"
 #include "config.h"
+#include "telemetry.h"
+#include "sampler.h"
+#include "throttle.h"
+#include "gpu_backend.h"
 #include <sstream>
 #include <iomanip>
 
@@ -8,7 +12,12 @@ string os, cpu, gpu, ram, kernel, driver;
 bool sysInfoFetched = false;
 double fps;
 uint64_t frametime;
-logData currentLogData = {};
+uint64_t runqueue_wait;
+// only used by whichever thread calls try_log()
+static telemetry_snapshot log_snapshot {};
+static uint64_t log_snapshot_version = 0;
+static fault_counters log_faults {};
+static bool log_faults_valid = false;
 
 std::unique_ptr<Logger> logger;
 
@@ -53,15 +62,90 @@ void upload_files(const std::vector<std::string>& logFiles){
   exec("xdg-open " + url);
 }
 
-void writeFile(string filename){
+// thread names can contain anything
+static void write_csv_name(std::ofstream& out, const char *name){
+  for (const char *c = name; *c; c++)
+    out << (*c == ',' || *c == '"' || *c == '\n' ? '_' : *c);
+}
+
+void writeFile(string filename, overlay_params *params){
+  bool sampler_stats = params->enabled[OVERLAY_PARAM_ENABLED_sampler_stats];
+  unsigned threads = params->enabled[OVERLAY_PARAM_ENABLED_thread_load] ? params->thread_load_count : 0;
+  bool procmem = params->enabled[OVERLAY_PARAM_ENABLED_procmem];
+#ifdef __gnu_linux__
+  bool psi = params->enabled[OVERLAY_PARAM_ENABLED_psi];
+#else
+  bool psi = false;
+#endif
+  bool wait = params->enabled[OVERLAY_PARAM_ENABLED_runqueue_wait];
+  bool faults = params->enabled[OVERLAY_PARAM_ENABLED_page_faults];
+  bool throttling = params->enabled[OVERLAY_PARAM_ENABLED_throttling_status];
+  bool disk = params->enabled[OVERLAY_PARAM_ENABLED_disk_stats];
   auto& logArray = logger->get_log_data();
+  auto& extras = logger->get_log_extras();
+  // names as the sampler published them, cpuIdleStats and the topology are its own
+  const std::vector<std::string>& cstate_names = extras.cstate_names;
+  unsigned cstates = params->enabled[OVERLAY_PARAM_ENABLED_cstates] ? cstate_names.size() : 0;
+  const std::vector<std::string>& cpu_groups = extras.cpu_group_keys;
+  bool cpu_power = params->enabled[OVERLAY_PARAM_ENABLED_cpu_power];
+  unsigned rapl = params->enabled[OVERLAY_PARAM_ENABLED_cpu_power_domains] ? extras.rapl_names.size() : 0;
+  // the primary GPU is in the gpu_* columns already
+  std::vector<unsigned> other_gpus;
+  for (size_t i = 0; gpus.ready() && gpus.size() > 1 && i < gpus.size(); i++)
+    if (gpus.is_sampled(i) && (int)i != gpus.primary())
+      other_gpus.push_back(i);
+  char reasons[32];
 #ifndef NDEBUG
   std::cerr << "Writing log file [" << filename << "], " << logArray.size() << " entries\n";
 #endif
   std::ofstream out(filename, ios::out | ios::app);
   out << "os," << "cpu," << "gpu," << "ram," << "kernel," << "driver" << endl;
   out << os << "," << cpu << "," << gpu << "," << ram << "," << kernel << "," << driver << endl;
-  out << "fps," << "frametime," << "cpu_load," << "gpu_load," << "cpu_temp," << "gpu_temp," << "gpu_core_clock," << "gpu_mem_clock," << "gpu_vram_used," << "ram_used," << "elapsed" << endl;
+  out << "fps," << "frametime," << "cpu_load," << "gpu_load," << "cpu_temp," << "gpu_temp," << "gpu_core_clock," << "gpu_mem_clock," << "gpu_vram_used," << "ram_used," << "elapsed";
+  // sampler self-cost goes last so existing columns keep their position
+  size_t sources = std::min<size_t>(hw_sampler.source_count(), SAMPLER_MAX_SOURCES);
+  if (sampler_stats) {
+    for (size_t i = 0; i < sources; i++)
+      out << "," << "sampler_" << hw_sampler.source_name(i) << "_us";
+    out << "," << "sampler_pass_min_us" << "," << "sampler_pass_avg_us" << "," << "sampler_pass_max_us";
+    out << "," << "sampler_reads" << "," << "sampler_syscalls";
+  }
+  for (unsigned i = 0; i < threads; i++)
+    out << "," << "thread" << i + 1 << "," << "thread" << i + 1 << "_load";
+  if (procmem)
+    out << "," << "proc_rss" << "," << "proc_pss" << "," << "proc_swap" << "," << "proc_mem_growth";
+#ifdef __gnu_linux__
+  if (psi) {
+    for (int r = 0; r < PSI_MAX; r++) {
+      out << "," << "psi_" << psi_resource_names[r] << "_some_avg10";
+      out << "," << "psi_" << psi_resource_names[r] << "_full_avg10";
+      out << "," << "psi_" << psi_resource_names[r] << "_some_us";
+      out << "," << "psi_" << psi_resource_names[r] << "_full_us";
+    }
+  }
+#endif
+  if (wait)
+    out << "," << "runqueue_wait";
+  if (faults)
+    out << "," << "minflt" << "," << "majflt" << "," << "pswpin" << "," << "pgmajfault";
+  if (throttling)
+    out << "," << "gpu_throttle" << "," << "cpu_throttle" << "," << "throttle_event";
+  if (disk)
+    out << "," << "disk_read" << "," << "disk_write" << "," << "disk_read_iops" << "," << "disk_write_iops" << "," << "disk_latency" << "," << "disk_util";
+  for (unsigned g : other_gpus) {
+    out << "," << "gpu" << g << "_load" << "," << "gpu" << g << "_temp";
+    out << "," << "gpu" << g << "_core_clock" << "," << "gpu" << g << "_mem_clock";
+    out << "," << "gpu" << g << "_vram_used" << "," << "gpu" << g << "_power";
+  }
+  for (unsigned c = 0; c < cstates; c++)
+    out << "," << "cstate_" << cstate_names[c] << "," << "cstate_" << cstate_names[c] << "_rate";
+  for (auto& key : cpu_groups)
+    out << "," << "cpu_" << key << "_load";
+  if (cpu_power)
+    out << "," << "cpu_power" << "," << "cpu_energy_uj";
+  for (unsigned d = 0; d < rapl; d++)
+    out << "," << "cpu_power_" << extras.rapl_names[d];
+  out << endl;
 
   for (size_t i = 0; i < logArray.size(); i++){
     out << logArray[i].fps << ",";
@@ -74,9 +158,125 @@ void writeFile(string filename){
     out << logArray[i].gpu_mem_clock << ",";
     out << logArray[i].gpu_vram_used << ",";
     out << logArray[i].ram_used << ",";
-    out << std::chrono::duration_cast<std::chrono::nanoseconds>(logArray[i].previous).count() << "\n";
+    out << std::chrono::duration_cast<std::chrono::nanoseconds>(logArray[i].previous).count();
+    // rows from before the option was on have none of its values
+    if (sampler_stats) {
+      log_sampler st {};
+      if (logArray[i].sampler.count)
+        st = extras.sampler[logArray[i].sampler.offset];
+      for (size_t j = 0; j < sources; j++)
+        out << "," << st.cost[j];
+      out << "," << st.pass.min;
+      out << "," << st.pass.avg;
+      out << "," << st.pass.max;
+      out << "," << st.reads;
+      out << "," << st.syscalls;
+    }
+    for (unsigned j = 0; j < threads; j++) {
+      top_thread thread {};
+      if (j < logArray[i].threads.count)
+        thread = extras.threads[logArray[i].threads.offset + j];
+      out << ",";
+      write_csv_name(out, thread.name);
+      out << "," << thread.percent;
+    }
+    if (procmem) {
+      log_procmem m {};
+      if (logArray[i].procmem.count)
+        m = extras.procmem[logArray[i].procmem.offset];
+      out << "," << m.rss;
+      out << "," << m.pss;
+      out << "," << m.swap;
+      out << "," << m.growth;
+    }
+    if (psi) {
+      for (int r = 0; r < PSI_MAX; r++) {
+        psi_sample s {};
+        if (logArray[i].psi.count)
+          s = extras.psi[logArray[i].psi.offset + r];
+        out << "," << s.some.avg10 << "," << s.full.avg10;
+        out << "," << s.some.delta << "," << s.full.delta;
+      }
+    }
+    if (wait)
+      out << "," << logArray[i].runqueue_wait;
+    if (faults) {
+      fault_counters f {};
+      if (logArray[i].faults.count)
+        f = extras.faults[logArray[i].faults.offset];
+      out << "," << f.minflt;
+      out << "," << f.majflt;
+      out << "," << f.pswpin;
+      out << "," << f.pgmajfault;
+    }
+    if (throttling) {
+      out << "," << throttle_reason_string(logArray[i].gpu_throttle, reasons, sizeof(reasons), '+');
+      out << "," << throttle_reason_string(logArray[i].cpu_throttle, reasons, sizeof(reasons), '+');
+      // the elapsed column of the row is when it happened
+      unsigned gpu_prev = i ? logArray[i - 1].gpu_throttle : 0;
+      unsigned cpu_prev = i ? logArray[i - 1].cpu_throttle : 0;
+      out << ",";
+      const char *sep = "";
+      if (!gpu_prev != !logArray[i].gpu_throttle) {
+        out << sep << (gpu_prev ? "gpu_end" : "gpu_start");
+        sep = " ";
+      }
+      if (!cpu_prev != !logArray[i].cpu_throttle)
+        out << sep << (cpu_prev ? "cpu_end" : "cpu_start");
+    }
+    if (disk) {
+      disk_sample d {};
+      if (logArray[i].disk.count)
+        d = extras.disk[logArray[i].disk.offset];
+      out << "," << d.read << "," << d.write;
+      out << "," << d.read_iops << "," << d.write_iops;
+      out << "," << d.latency << "," << d.util;
+    }
+    for (unsigned g : other_gpus) {
+      log_gpu info {};
+      for (uint32_t j = 0; j < logArray[i].gpus.count; j++)
+        if (extras.gpus[logArray[i].gpus.offset + j].index == g)
+          info = extras.gpus[logArray[i].gpus.offset + j];
+      out << "," << info.load << "," << info.temp;
+      out << "," << info.core_clock << "," << info.mem_clock;
+      out << "," << info.vram_used << "," << info.power;
+    }
+    for (unsigned c = 0; c < cstates; c++) {
+      cpuidle_sample idle {};
+      if (logArray[i].cstates.count)
+        idle = extras.cstates[logArray[i].cstates.offset];
+      out << "," << idle.residency[c] << "," << idle.rate[c];
+    }
+    for (size_t g = 0; g < cpu_groups.size(); g++)
+      out << "," << (g < logArray[i].cpu_groups.count ? extras.cpu_groups[logArray[i].cpu_groups.offset + g] : 0.f);
+    if (cpu_power) {
+      log_cpu_power p {};
+      if (logArray[i].cpu_power.count)
+        p = extras.cpu_power[logArray[i].cpu_power.offset];
+      out << "," << p.power << "," << p.energy;
+    }
+    for (unsigned d = 0; d < rapl; d++)
+      out << "," << (d < logArray[i].rapl.count ? extras.rapl[logArray[i].rapl.offset + d] : 0.f);
+    out << "\n";
   }
   logger->clear_log_data();
+
+  uint64_t start;
+  std::vector<gpu_sample> samples = logger->take_gpu_samples(start);
+  if (samples.empty())
+    return;
+  // one row per driver sample, too many to join with the rows above
+  std::string samples_file = filename.substr(0, filename.size() - 4) + "_gpu_samples.csv";
+  std::ofstream samples_out(samples_file, ios::out | ios::app);
+  samples_out << "gpu_load," << "gpu_mem_load," << "gpu_core_clock," << "gpu_mem_clock," << "elapsed" << endl;
+  for (auto& s : samples) {
+    samples_out << s.load << ",";
+    samples_out << s.mem_load << ",";
+    samples_out << s.CoreClock << ",";
+    samples_out << s.MemClock << ",";
+    // add_gpu_samples() drops older ones, never wrap around if one gets through
+    samples_out << (s.timestamp > start ? (s.timestamp - start) * 1000 : 0) << "\n";
+  }
 }
 
 string get_log_suffix(){
@@ -112,6 +312,15 @@ void Logger::start_logging() {
   m_values_valid = false;
   m_logging_on = true;
   m_log_start = Clock::now();
+  {
+    // the sampler thread reads it with the samples
+    std::lock_guard<std::mutex> lck(m_gpu_samples_mtx);
+    // NVML stamps its samples with the wall clock
+    m_log_start_realtime = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count();
+    m_gpu_samples.clear();
+  }
+  log_faults_valid = false;
   if((not m_params->output_folder.empty()) and (m_params->log_interval != 0)){
     std::thread(logging, m_params).detach();
   }
@@ -126,26 +335,134 @@ void Logger::stop_logging() {
 
   if(not m_params->output_folder.empty()) {
     m_log_files.emplace_back(m_params->output_folder + "/" + program_name + "_" + get_log_suffix());
-    std::thread(writeFile, m_log_files.back()).detach();
+    std::thread(writeFile, m_log_files.back(), m_params).detach();
   }
 }
 
+// a range of to for the row
+template <typename T>
+static log_range append_extras(std::vector<T>& to, const T *from, unsigned count) {
+  log_range range {uint32_t(to.size()), count};
+  to.insert(to.end(), from, from + count);
+  return range;
+}
+
+void log_extras::clear() {
+  sampler.clear();
+  threads.clear();
+  procmem.clear();
+  psi.clear();
+  faults.clear();
+  disk.clear();
+  gpus.clear();
+  cstates.clear();
+  cpu_groups.clear();
+  cpu_power.clear();
+  rapl.clear();
+  cstate_names.clear();
+  cpu_group_keys.clear();
+  rapl_names.clear();
+}
+
 void Logger::try_log() {
   if(not is_active()) return;
   if(not m_values_valid) return;
   auto now = Clock::now();
   auto elapsedLog = now - m_log_start;
 
-  currentLogData.previous = elapsedLog;
-  currentLogData.fps = fps;
-  currentLogData.frametime = frametime;
-  m_log_array.push_back(currentLogData);
+  telemetry.load_if_newer(log_snapshot, log_snapshot_version);
+  logData data = log_snapshot.log;
+  data.previous = elapsedLog;
+  data.fps = fps;
+  data.frametime = frametime;
+  data.runqueue_wait = runqueue_wait;
+  const bool *enabled = m_params->enabled;
+  log_extras& x = m_log_extras;
+  if (enabled[OVERLAY_PARAM_ENABLED_sampler_stats]) {
+    log_sampler st {log_snapshot.pass_cost, log_snapshot.sampler_reads, log_snapshot.sampler_syscalls, {}};
+    for (unsigned i = 0; i < log_snapshot.cost_count; i++)
+      st.cost[i] = log_snapshot.costs[i].avg;
+    data.sampler = append_extras(x.sampler, &st, 1);
+  }
+  if (enabled[OVERLAY_PARAM_ENABLED_thread_load])
+    data.threads = append_extras(x.threads, log_snapshot.threads, log_snapshot.thread_count);
+  if (enabled[OVERLAY_PARAM_ENABLED_procmem])
+    data.procmem = append_extras(x.procmem, &log_snapshot.procmem, 1);
+  if (enabled[OVERLAY_PARAM_ENABLED_psi])
+    data.psi = append_extras(x.psi, log_snapshot.psi, PSI_MAX);
+  if (enabled[OVERLAY_PARAM_ENABLED_disk_stats])
+    data.disk = append_extras(x.disk, &log_snapshot.disk, 1);
+  data.gpus.offset = x.gpus.size();
+  for (unsigned i = 0; i < log_snapshot.gpu_count; i++) {
+    const telemetry_gpu& g = log_snapshot.gpus[i];
+    if (g.primary)
+      continue;
+    x.gpus.push_back({g.index, g.info.load, g.info.temp, g.info.CoreClock,
+                      g.info.MemClock, g.info.memoryUsed, g.info.powerUsage});
+  }
+  data.gpus.count = x.gpus.size() - data.gpus.offset;
+  if (enabled[OVERLAY_PARAM_ENABLED_cstates]) {
+    data.cstates = append_extras(x.cstates, &log_snapshot.cstates, 1);
+    // the states are known after the first cpuidle pass
+    if (log_snapshot.cstates.count > x.cstate_names.size())
+      x.cstate_names.assign(log_snapshot.cstate_names, log_snapshot.cstate_names + log_snapshot.cstates.count);
+  }
+  for (unsigned i = 0; i < log_snapshot.cpu_group_count; i++)
+    x.cpu_groups.push_back(log_snapshot.cpu_groups[i].avg);
+  data.cpu_groups = {uint32_t(x.cpu_groups.size() - log_snapshot.cpu_group_count), log_snapshot.cpu_group_count};
+  // the same groups in every row once the topology is read
+  if (log_snapshot.cpu_group_count > x.cpu_group_keys.size()) {
+    x.cpu_group_keys.clear();
+    for (unsigned i = 0; i < log_snapshot.cpu_group_count; i++)
+      x.cpu_group_keys.push_back(log_snapshot.cpu_groups[i].key);
+  }
+  if (enabled[OVERLAY_PARAM_ENABLED_cpu_power]) {
+    log_cpu_power p {log_snapshot.cpu.power, log_snapshot.cpu.energy};
+    data.cpu_power = append_extras(x.cpu_power, &p, 1);
+  }
+  if (enabled[OVERLAY_PARAM_ENABLED_cpu_power_domains]) {
+    data.rapl.offset = x.rapl.size();
+    for (unsigned i = 0; i < log_snapshot.rapl_domain_count; i++)
+      x.rapl.push_back(log_snapshot.rapl_domains[i].power);
+    data.rapl.count = log_snapshot.rapl_domain_count;
+    // the domains are found with the first power reading
+    if (log_snapshot.rapl_domain_count > x.rapl_names.size()) {
+      x.rapl_names.clear();
+      for (unsigned i = 0; i < log_snapshot.rapl_domain_count; i++)
+        x.rapl_names.push_back(log_snapshot.rapl_domains[i].name);
+    }
+  }
+#ifdef __gnu_linux__
+  // the sampler keeps totals, so rows closer than a sampler pass don't count twice
+  if (enabled[OVERLAY_PARAM_ENABLED_page_faults] && log_faults_valid) {
+    fault_counters delta = fault_delta(log_snapshot.faults_total, log_faults);
+    data.faults = append_extras(x.faults, &delta, 1);
+  }
+  log_faults = log_snapshot.faults_total;
+  log_faults_valid = true;
+#endif
+  m_log_array.push_back(data);
 
   if(m_params->log_duration and (elapsedLog >= std::chrono::seconds(m_params->log_duration))){
     stop_logging();
   }
 }
 
+void Logger::add_gpu_samples(const gpu_sample *samples, unsigned count) {
+  std::lock_guard<std::mutex> lck(m_gpu_samples_mtx);
+  for (unsigned i = 0; i < count; i++)
+    if (samples[i].timestamp >= m_log_start_realtime)
+      m_gpu_samples.push_back(samples[i]);
+}
+
+std::vector<gpu_sample> Logger::take_gpu_samples(uint64_t& start) {
+  std::lock_guard<std::mutex> lck(m_gpu_samples_mtx);
+  start = m_log_start_realtime;
+  std::vector<gpu_sample> samples;
+  samples.swap(m_gpu_samples);
+  return samples;
+}
+
 void Logger::wait_until_data_valid() {
   std::unique_lock<std::mutex> lck(m_values_valid_mtx);
   while(! m_values_valid) m_values_valid_cv.wait(lck);
@@ -12,8 +12,75 @@
 #include "timing.hpp"
 
 #include "overlay_params.h"
+#include "psi.h"
+#include "faults.h"
+#include "diskstats.h"
+#include "cpuidle.h"
+#include "cpu_topology.h"
+#include "gpu.h"
 
 using namespace std;
+
+#define SAMPLER_MAX_SOURCES 32
+
+// busiest thread names of the process
+#define MAX_TOP_THREADS 8
+
+struct top_thread {
+  char name[16];
+  unsigned count;  // threads with that name
+  float percent;   // of one core
+};
+
+// rolling duration of a sampler step, in us
+struct telemetry_cost {
+  const char *name;
+  float min;
+  float avg;
+  float max;
+};
+
+// a GPU besides the primary one, the gpu<N>_* columns of a row
+struct log_gpu {
+  unsigned index;
+  int load;
+  int temp;
+  int core_clock;
+  int mem_clock;
+  float vram_used;
+  int power;
+};
+
+// sampler self-cost, the whole pass and the average per source
+struct log_sampler {
+  struct telemetry_cost pass;
+  // reads in the io_uring batch of the pass and the syscalls they took
+  unsigned reads;
+  unsigned syscalls;
+  float cost[SAMPLER_MAX_SOURCES];
+};
+
+// process footprint in GiB, growth in MiB/s
+struct log_procmem {
+  float rss;
+  float pss;
+  float swap;
+  float growth;
+};
+
+// cpu_power of a row, W and uJ since power sampling started
+struct log_cpu_power {
+  float power;
+  uint64_t energy;
+};
+
+// a row's entries in one of the log_extras vectors, none when the option
+// was off for it
+struct log_range {
+  uint32_t offset;
+  uint32_t count;
+};
+
 struct logData{
   double fps;
   uint64_t frametime;
@@ -25,10 +92,53 @@ struct logData{
   int gpu_mem_clock;
   float gpu_vram_used;
   float ram_used;
+  // of the presenting thread during the last frame, us
+  uint64_t runqueue_wait;
+  // THROTTLE_* reasons
+  unsigned gpu_throttle;
+  unsigned cpu_throttle;
+  // the optional columns, in Logger::get_log_extras()
+  struct log_range sampler;
+  struct log_range threads;
+  struct log_range procmem;
+  struct log_range psi;
+  // faults since the previous log entry
+  struct log_range faults;
+  // block device the game is installed on
+  struct log_range disk;
+  // the other sampled GPUs
+  struct log_range gpus;
+  struct log_range cstates;
+  // average load of the core_load_group groups
+  struct log_range cpu_groups;
+  struct log_range cpu_power;
+  // W of each RAPL domain
+  struct log_range rapl;
 
   Clock::duration previous;
 };
 
+// What a row only keeps while the option is on, most of the time nothing
+struct log_extras {
+  std::vector<log_sampler> sampler;
+  std::vector<top_thread> threads;
+  std::vector<log_procmem> procmem;
+  std::vector<psi_sample> psi;
+  std::vector<fault_counters> faults;
+  std::vector<disk_sample> disk;
+  std::vector<log_gpu> gpus;
+  std::vector<cpuidle_sample> cstates;
+  std::vector<float> cpu_groups;
+  std::vector<log_cpu_power> cpu_power;
+  std::vector<float> rapl;
+  // column names, as the sampler published them
+  std::vector<std::string> cstate_names;
+  std::vector<std::string> cpu_group_keys;
+  std::vector<std::string> rapl_names;
+
+  void clear();
+};
+
 class Logger {
 public:
   Logger(overlay_params* in_params);
@@ -47,12 +157,19 @@ public:
   auto last_log_begin() const noexcept { return m_log_start; }
 
   const std::vector<logData>& get_log_data() const noexcept { return m_log_array; }
-  void clear_log_data() noexcept { m_log_array.clear(); }
+  const log_extras& get_log_extras() const noexcept { return m_log_extras; }
+  void clear_log_data() noexcept { m_log_array.clear(); m_log_extras.clear(); }
+
+  // NVML samples, called from the sampler thread while logging
+  void add_gpu_samples(const gpu_sample *samples, unsigned count);
+  // the samples of the last log and its start in their clock, in us
+  std::vector<gpu_sample> take_gpu_samples(uint64_t& start);
 
   void upload_last_log();
   void upload_last_logs();
 private:
   std::vector<logData> m_log_array;
+  log_extras m_log_extras;
   std::vector<std::string> m_log_files;
   Clock::time_point m_log_start;
   Clock::time_point m_log_end;
@@ -62,6 +179,11 @@ private:
   std::condition_variable m_values_valid_cv;
   bool m_values_valid;
 
+  std::mutex m_gpu_samples_mtx;
+  std::vector<gpu_sample> m_gpu_samples;
+  // us, CLOCK_REALTIME like the samples
+  uint64_t m_log_start_realtime = 0;
+
   overlay_params* m_params;
 };
 
@@ -71,7 +193,7 @@ extern string os, cpu, gpu, ram, kernel, driver;
 extern bool sysInfoFetched;
 extern double fps;
 extern uint64_t frametime;
-extern logData currentLogData;
+extern uint64_t runqueue_wait;
 
 string exec(string command);
 void autostart_log(int sleep);
@@ -4,9 +4,17 @@
 #include <stdio.h>
 #include <iostream>
 #include <thread>
+#include "file_utils.h"
+#include "sysfs_counters.h"
+#include "mesa/util/os_time.h"
+
+#ifndef PROCMEMINFOFILE
+#define PROCMEMINFOFILE "/proc/meminfo"
+#endif
 
 struct memory_information mem_info;
 float memused, memmax;
+struct process_memory proc_mem;
 
 FILE *open_file(const char *file, int *reported) {
   FILE *fp = nullptr;
@@ -24,12 +32,85 @@ FILE *open_file(const char *file, int *reported) {
   return fp;
 }
 
-void update_meminfo(void) {
-  FILE *meminfo_fp;
-  static int reported = 0;
+// the keys update_meminfo() needs, in the order the kernel prints them
+struct meminfo_values {
+  unsigned long long memmax, memfree, memavail, buffers, cached, swapmax,
+      swapfree, memdirty, shmem, sreclaimable;
+};
+
+#define MEMINFO_KEY(key, field) { key, sizeof(key) - 1, &meminfo_values::field }
+
+static const struct {
+  const char *key;
+  size_t len;
+  unsigned long long meminfo_values::*field;
+} meminfo_keys[] = {
+  MEMINFO_KEY("MemTotal:", memmax),
+  MEMINFO_KEY("MemFree:", memfree),
+  MEMINFO_KEY("MemAvailable:", memavail),
+  MEMINFO_KEY("Buffers:", buffers),
+  MEMINFO_KEY("Cached:", cached),
+  MEMINFO_KEY("SwapTotal:", swapmax),
+  MEMINFO_KEY("SwapFree:", swapfree),
+  MEMINFO_KEY("Dirty:", memdirty),
+  MEMINFO_KEY("Shmem:", shmem),
+  MEMINFO_KEY("SReclaimable:", sreclaimable),
+};
+
+#define MEMINFO_KEY_COUNT (sizeof(meminfo_keys) / sizeof(meminfo_keys[0]))
+
+static counter_set meminfo_counters;
+static int meminfo_idx = -1;
+
+static void init_meminfo() {
+  static bool inited = false;
+  if (!inited) {
+    // about 1.5 KiB, more with hugepages and CMA
+    meminfo_idx = meminfo_counters.add(PROCMEMINFOFILE, 4096);
+    inited = true;
+  }
+}
+
+void queue_meminfo(io_uring_reader& reader) {
+  init_meminfo();
+  meminfo_counters.queue(reader);
+}
 
-  /* unsigned int a; */
-  char buf[256];
+// One pass over the text, each line is matched against the keys that were
+// not found yet. Returns the number of keys found.
+static size_t parse_meminfo(const char *p, meminfo_values& values) {
+  bool found[MEMINFO_KEY_COUNT] = {};
+  size_t count = 0;
+
+  while (*p && count < MEMINFO_KEY_COUNT) {
+    // keys mostly come in table order, start looking after the last match
+    for (size_t n = 0, i = count; n < MEMINFO_KEY_COUNT; n++, i = (i + 1) % MEMINFO_KEY_COUNT) {
+      if (found[i] || strncmp(p, meminfo_keys[i].key, meminfo_keys[i].len))
+        continue;
+
+      const char *v = p + meminfo_keys[i].len;
+      while (*v == ' ')
+        v++;
+      unsigned long long value = 0;
+      while (*v >= '0' && *v <= '9')
+        value = value * 10 + (*v++ - '0');
+
+      values.*meminfo_keys[i].field = value;
+      found[i] = true;
+      count++;
+      break;
+    }
+
+    p = strchr(p, '\n');
+    if (!p)
+      break;
+    p++;
+  }
+  return count;
+}
+
+void update_meminfo(void) {
+  init_meminfo();
 
   /* With multi-threading, calculations that require
    * multple steps to reach a final result can cause havok
@@ -37,40 +118,20 @@ void update_meminfo(void) {
    * information struct (they may be read by other functions in the meantime).
    * These variables keep the calculations local to the function and finish off
    * the function by assigning the results to the information struct */
-  unsigned long long shmem = 0, sreclaimable = 0, curmem = 0, curbufmem = 0,
-                     cureasyfree = 0, memavail = 0;
-
-  mem_info.memmax = mem_info.memdirty = mem_info.swap = mem_info.swapfree = mem_info.swapmax =
-      mem_info.memwithbuffers = mem_info.buffers = mem_info.cached = mem_info.memfree =
-          mem_info.memeasyfree = 0;
-
-  if (!(meminfo_fp = open_file("/proc/meminfo", &reported))) { }
-
-  while (!feof(meminfo_fp)) {
-    if (fgets(buf, 255, meminfo_fp) == nullptr) { break; }
-
-    if (strncmp(buf, "MemTotal:", 9) == 0) {
-      sscanf(buf, "%*s %llu", &mem_info.memmax);
-    } else if (strncmp(buf, "MemFree:", 8) == 0) {
-      sscanf(buf, "%*s %llu", &mem_info.memfree);
-    } else if (strncmp(buf, "SwapTotal:", 10) == 0) {
-      sscanf(buf, "%*s %llu", &mem_info.swapmax);
-    } else if (strncmp(buf, "SwapFree:", 9) == 0) {
-      sscanf(buf, "%*s %llu", &mem_info.swapfree);
-    } else if (strncmp(buf, "Buffers:", 8) == 0) {
-      sscanf(buf, "%*s %llu", &mem_info.buffers);
-    } else if (strncmp(buf, "Cached:", 7) == 0) {
-      sscanf(buf, "%*s %llu", &mem_info.cached);
-    } else if (strncmp(buf, "Dirty:", 6) == 0) {
-      sscanf(buf, "%*s %llu", &mem_info.memdirty);
-    } else if (strncmp(buf, "MemAvailable:", 13) == 0) {
-      sscanf(buf, "%*s %llu", &memavail);
-    } else if (strncmp(buf, "Shmem:", 6) == 0) {
-      sscanf(buf, "%*s %llu", &shmem);
-    } else if (strncmp(buf, "SReclaimable:", 13) == 0) {
-      sscanf(buf, "%*s %llu", &sreclaimable);
-    }
-  }
+  unsigned long long curmem = 0, curbufmem = 0, cureasyfree = 0;
+  meminfo_values v {};
+
+  meminfo_counters.update();
+  if (!parse_meminfo(meminfo_counters.text(meminfo_idx), v))
+    return;
+
+  mem_info.memmax = v.memmax;
+  mem_info.memfree = v.memfree;
+  mem_info.swapmax = v.swapmax;
+  mem_info.swapfree = v.swapfree;
+  mem_info.buffers = v.buffers;
+  mem_info.cached = v.cached;
+  mem_info.memdirty = v.memdirty;
 
   curmem = mem_info.memwithbuffers = mem_info.memmax - mem_info.memfree;
   cureasyfree = mem_info.memfree;
@@ -81,9 +142,9 @@ void update_meminfo(void) {
      Note: when shared memory is swapped out, shmem decreases and swapfree
      decreases - we want this.
   */
-  curbufmem = (mem_info.cached - shmem) + mem_info.buffers + sreclaimable;
+  curbufmem = (mem_info.cached - v.shmem) + mem_info.buffers + v.sreclaimable;
 
-  curmem = mem_info.memmax - memavail;
+  curmem = mem_info.memmax - v.memavail;
   cureasyfree += curbufmem;
 
   /* Now that we know that every calculation is finished we can wrap up
@@ -94,6 +155,51 @@ void update_meminfo(void) {
 
   memused = (float(mem_info.memmax) - float(mem_info.memeasyfree)) / (1024 * 1024);
   memmax = float(mem_info.memmax) / (1024 * 1024);
+}
+
+void update_procmem(void) {
+  static pread_file file;
+  static bool rollup = false;
+  static uint64_t last_update = 0;
+  static float last_rss = 0;
+  char buf[2048];
+
+  if (!file.is_open()) {
+    // smaps_rollup is missing before 4.14, status has no Pss
+    rollup = file.open("/proc/self/smaps_rollup");
+    if (!rollup && !file.open("/proc/self/status"))
+      return;
+  }
+
+  if (file.read(buf, sizeof(buf)) <= 0)
+    return;
+
+  unsigned long long rss = 0, pss = 0, swap = 0;
+  char *saveptr = nullptr;
+  for (char *line = strtok_r(buf, "\n", &saveptr); line; line = strtok_r(nullptr, "\n", &saveptr)) {
+    if (rollup) {
+      if (strncmp(line, "Rss:", 4) == 0)
+        sscanf(line, "%*s %llu", &rss);
+      else if (strncmp(line, "Pss:", 4) == 0)
+        sscanf(line, "%*s %llu", &pss);
+      else if (strncmp(line, "Swap:", 5) == 0)
+        sscanf(line, "%*s %llu", &swap);
+    } else {
+      if (strncmp(line, "VmRSS:", 6) == 0)
+        sscanf(line, "%*s %llu", &rss);
+      else if (strncmp(line, "VmSwap:", 7) == 0)
+        sscanf(line, "%*s %llu", &swap);
+    }
+  }
+
+  /* kB */
+  proc_mem.rss = float(rss) / (1024 * 1024);
+  proc_mem.pss = float(pss) / (1024 * 1024);
+  proc_mem.swap = float(swap) / (1024 * 1024);
 
-  fclose(meminfo_fp);
+  uint64_t now = os_time_get_nano();
+  if (last_update)
+    proc_mem.growth = (proc_mem.rss - last_rss) * 1024 / ((now - last_update) / 1e9f);
+  last_update = now;
+  last_rss = proc_mem.rss;
 }
@@ -15,7 +15,20 @@ struct memory_information {
   unsigned long long bufmem, buffers, cached;
 };
 
+// footprint of this process
+struct process_memory {
+  float rss, pss, swap; /* GiB */
+  float growth;         /* MiB/s of rss since the last update */
+};
+
+extern struct process_memory proc_mem;
+
+class io_uring_reader;
+
 void update_meminfo(void);
+void queue_meminfo(io_uring_reader& reader);
+// smaps_rollup walks every mapping of the process, keep it off the fast path
+void update_procmem(void);
 FILE *open_file(const char *file, int *reported);
 
 #endif //MANGOHUD_MEMORY_H
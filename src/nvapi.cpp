@@ -2,6 +2,7 @@
 #include <iostream>
 #include "nvidia_info.h"
 #include "gpu.h"
+#include "gpu_backend.h"
 
 // magic numbers, do not change them
 #define NVAPI_MAX_PHYSICAL_GPUS   64
@@ -53,7 +54,7 @@ bool checkNVAPI(){
     return true;
 }
 
-void nvapi_util()
+void nvapi_util(struct gpuInfo& info)
 {  
     if (!init_nvapi_bool){
         init_nvapi_bool = checkNVAPI();
@@ -62,6 +63,25 @@ void nvapi_util()
     gpuUsages[0] = (NVAPI_MAX_USAGES_PER_GPU * 4) | 0x10000;
     (*NvAPI_EnumPhysicalGPUs)(gpuHandles, &gpuCount);
     (*NvAPI_GPU_GetUsages)(gpuHandles[0], gpuUsages);
-    gpu_info.load = gpuUsages[3];
+    info.load = gpuUsages[3];
 
-}
\ No newline at end of file
+}
+
+class nvapi_backend : public gpu_backend
+{
+public:
+    using gpu_backend::gpu_backend;
+
+    const char *name() const override { return "nvapi"; }
+    bool update(gpuInfo& info) override { nvapi_util(info); return true; }
+};
+
+// only the load of the first GPU
+void probe_nvapi(const overlay_params& params, gpu_backend_list& devices)
+{
+    for (auto& dev : devices)
+        if (dev->vendor_id() == 0x10de)
+            return;
+    if (checkNVAPI())
+        devices.push_back(std::make_unique<nvapi_backend>(0x10de, 0, std::string()));
+}
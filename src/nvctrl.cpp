@@ -9,6 +9,7 @@
 #include "loaders/loader_x11.h"
 #include "string_utils.h"
 #include "overlay.h"
+#include "gpu_backend.h"
 
 typedef std::unordered_map<std::string, std::string> string_map;
 static std::unique_ptr<Display, std::function<void(Display*)>> display;
@@ -61,17 +62,20 @@ bool checkXNVCtrl()
             local_x11->XCloseDisplay(dpy);
         }
     };
-    // get device id at init
-    int64_t pci_id;
+    return true;
+}
+
+static uint32_t get_nvctrl_device_id()
+{
+    auto& nvctrl = get_libnvctrl_loader();
+    int64_t pci_id = 0;
     nvctrl.XNVCTRLQueryTargetAttribute64(display.get(),
                     NV_CTRL_TARGET_TYPE_GPU,
                     0,
                     0,
                     NV_CTRL_PCI_ID,
                     &pci_id);
-    deviceID = (pci_id & 0xFFFF);
-
-    return true;
+    return pci_id & 0xFFFF;
 }
 
 static void parse_token(std::string token, string_map& options) {
@@ -159,3 +163,33 @@ void getNvctrlInfo(){
                         &memused);
     nvctrl_info.memoryUsed = memused;
 }
+
+class nvctrl_backend : public gpu_backend
+{
+public:
+    using gpu_backend::gpu_backend;
+
+    const char *name() const override { return "xnvctrl"; }
+
+    bool update(gpuInfo& info) override {
+        getNvctrlInfo();
+        info.load = nvctrl_info.load;
+        info.temp = nvctrl_info.temp;
+        info.memoryUsed = nvctrl_info.memoryUsed / (1024.f);
+        info.CoreClock = nvctrl_info.CoreClock;
+        info.MemClock = nvctrl_info.MemClock;
+        info.powerUsage = 0;
+        info.memoryTotal = nvctrl_info.memoryTotal;
+        return true;
+    }
+};
+
+// the first GPU of the first NVIDIA X screen, when NVML is not there
+void probe_xnvctrl(const overlay_params&, gpu_backend_list& devices)
+{
+    for (auto& dev : devices)
+        if (dev->vendor_id() == 0x10de)
+            return;
+    if (checkXNVCtrl())
+        devices.push_back(std::make_unique<nvctrl_backend>(0x10de, get_nvctrl_device_id(), std::string()));
+}
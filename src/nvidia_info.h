@@ -3,15 +3,15 @@
 #define MANGOHUD_NVIDIA_INFO_H
 
 #include <nvml.h>
+#include "gpu.h"
 
-extern nvmlReturn_t result;
-extern unsigned int nvidiaTemp, processSamplesCount, *vgpuInstanceSamplesCount, nvidiaCoreClock, nvidiaMemClock, nvidiaPowerUsage;
+// the primary device, when it is an NVIDIA one NVML can read
 extern nvmlDevice_t nvidiaDevice;
-extern struct nvmlUtilization_st nvidiaUtilization;
-extern struct nvmlMemory_st nvidiaMemory;
 extern bool nvmlSuccess;
 
-bool checkNVML(const char* pciBusId);
-bool getNVMLInfo(void);
+bool getNVMLProcessInfo(struct gpuProcInfo& info);
+unsigned getNVMLThrottleReasons(void);
+// newest samples since the previous call, at most max of them
+unsigned getNVMLSamples(struct gpu_sample *samples, unsigned max);
 
 #endif //MANGOHUD_NVIDIA_INFO_H
@@ -1,60 +1,257 @@
 #include "loaders/loader_nvml.h"
 #include "nvidia_info.h"
 #include <iostream>
-#include "overlay.h"
+#include <vector>
+#include <algorithm>
+#include <unistd.h>
+#include "throttle.h"
+#include "gpu_backend.h"
 
-nvmlReturn_t result;
 nvmlDevice_t nvidiaDevice;
-nvmlPciInfo_t nvidiaPciInfo;
 bool nvmlSuccess = false;
-unsigned int nvidiaTemp = 0, nvidiaCoreClock = 0, nvidiaMemClock = 0, nvidiaPowerUsage = 0;
-struct nvmlUtilization_st nvidiaUtilization;
-struct nvmlMemory_st nvidiaMemory {};
 
-bool checkNVML(const char* pciBusId){
+static bool nvml_init(){
+    static bool inited = false, ok = false;
+    if (inited)
+        return ok;
+    inited = true;
+
     auto& nvml = get_libnvml_loader();
-    if (nvml.IsLoaded()){
-        result = nvml.nvmlInit();
-        if (NVML_SUCCESS != result) {
-            std::cerr << "MANGOHUD: Nvidia module not loaded\n";
-        } else {
-            nvmlReturn_t ret = NVML_ERROR_UNKNOWN;
-            if (pciBusId && ((ret = nvml.nvmlDeviceGetHandleByPciBusId(pciBusId, &nvidiaDevice)) != NVML_SUCCESS)) {
-                std::cerr << "MANGOHUD: Getting device handle by PCI bus ID failed: " << nvml.nvmlErrorString(ret) << "\n";
-                std::cerr << "          Using index 0.\n";
-            }
-
-            if (ret != NVML_SUCCESS)
-                ret = nvml.nvmlDeviceGetHandleByIndex(0, &nvidiaDevice);
-
-            if (ret != NVML_SUCCESS)
-                std::cerr << "MANGOHUD: Getting device handle failed: " << nvml.nvmlErrorString(ret) << "\n";
-
-            nvmlSuccess = (ret == NVML_SUCCESS);
-            if (ret == NVML_SUCCESS)
-                nvml.nvmlDeviceGetPciInfo_v3(nvidiaDevice, &nvidiaPciInfo);
-                
-            return nvmlSuccess;
-        }
-    } else {
+    if (!nvml.IsLoaded()) {
         std::cerr << "MANGOHUD: Failed to load NVML\n";
+        return false;
+    }
+    if (nvml.nvmlInit() != NVML_SUCCESS) {
+        std::cerr << "MANGOHUD: Nvidia module not loaded\n";
+        return false;
+    }
+    ok = true;
+    return true;
+}
+
+class nvml_backend : public gpu_backend
+{
+public:
+    nvml_backend(nvmlDevice_t device, uint32_t device_id, const std::string& pci_dev)
+        : gpu_backend(0x10de, device_id, pci_dev), m_device(device) {}
+
+    const char *name() const override { return "nvml"; }
+
+    bool update(gpuInfo& info) override {
+        auto& nvml = get_libnvml_loader();
+        nvmlUtilization_t utilization {};
+        nvmlMemory_t memory {};
+        unsigned int temp = 0, core = 0, mem = 0, power = 0;
+
+        nvmlReturn_t response = nvml.nvmlDeviceGetUtilizationRates(m_device, &utilization);
+        if (response == NVML_ERROR_NOT_SUPPORTED)
+            return false;
+        nvml.nvmlDeviceGetTemperature(m_device, NVML_TEMPERATURE_GPU, &temp);
+        nvml.nvmlDeviceGetMemoryInfo(m_device, &memory);
+        nvml.nvmlDeviceGetClockInfo(m_device, NVML_CLOCK_GRAPHICS, &core);
+        nvml.nvmlDeviceGetClockInfo(m_device, NVML_CLOCK_MEM, &mem);
+        nvml.nvmlDeviceGetPowerUsage(m_device, &power);
+
+        info.load = utilization.gpu;
+        info.temp = temp;
+        info.memoryUsed = memory.used / (1024.f * 1024.f * 1024.f);
+        info.memoryTotal = memory.total / (1024.f * 1024.f * 1024.f);
+        info.CoreClock = core;
+        info.MemClock = mem;
+        info.powerUsage = power / 1000;
+        return true;
+    }
+
+    // process stats, throttle reasons and samples are of the primary device
+    void bind() override {
+        nvidiaDevice = m_device;
+        nvmlSuccess = true;
+    }
+
+private:
+    nvmlDevice_t m_device;
+};
+
+void probe_nvml(const overlay_params&, gpu_backend_list& devices){
+    if (!nvml_init())
+        return;
+
+    auto& nvml = get_libnvml_loader();
+    unsigned int count = 0;
+    nvmlReturn_t ret = nvml.nvmlDeviceGetCount(&count);
+    if (ret != NVML_SUCCESS) {
+        std::cerr << "MANGOHUD: Getting the NVML device count failed: " << nvml.nvmlErrorString(ret) << "\n";
+        return;
+    }
+
+    for (unsigned int i = 0; i < count; i++) {
+        nvmlDevice_t device;
+        nvmlPciInfo_t pci {};
+        if ((ret = nvml.nvmlDeviceGetHandleByIndex(i, &device)) != NVML_SUCCESS) {
+            std::cerr << "MANGOHUD: Getting device handle failed: " << nvml.nvmlErrorString(ret) << "\n";
+            continue;
+        }
+
+        // sysfs style address, NVML's busId has an 8 digit domain
+        char pci_dev[16] {};
+        if (nvml.nvmlDeviceGetPciInfo_v3(device, &pci) == NVML_SUCCESS)
+            snprintf(pci_dev, sizeof(pci_dev), "%04x:%02x:%02x.0", pci.domain, pci.bus, pci.device);
+        devices.push_back(std::make_unique<nvml_backend>(device, pci.pciDeviceId >> 16, pci_dev));
+    }
+}
+
+// NVML keeps a buffer of per process samples, only those newer than the
+// last call are returned and only for processes that used the GPU
+bool getNVMLProcessInfo(struct gpuProcInfo& info){
+    static std::vector<nvmlProcessUtilizationSample_t> samples(16);
+    static std::vector<nvmlProcessInfo_t> procs(16);
+    static unsigned long long lastSeen = 0;
+    auto& nvml = get_libnvml_loader();
+    unsigned int pid = getpid();
+
+    unsigned int count = samples.size();
+    nvmlReturn_t ret = nvml.nvmlDeviceGetProcessUtilization(nvidiaDevice, samples.data(), &count, lastSeen);
+    if (ret == NVML_ERROR_INSUFFICIENT_SIZE) {
+        samples.resize(count);
+        ret = nvml.nvmlDeviceGetProcessUtilization(nvidiaDevice, samples.data(), &count, lastSeen);
+    }
+
+    if (ret == NVML_SUCCESS) {
+        const nvmlProcessUtilizationSample_t *own = nullptr;
+        for (unsigned i = 0; i < count; i++) {
+            lastSeen = std::max(lastSeen, samples[i].timeStamp);
+            if (samples[i].pid == pid && (!own || samples[i].timeStamp > own->timeStamp))
+                own = &samples[i];
+        }
+
+        const struct { const char *name; unsigned value; } engines[] = {
+            { "3d", own ? own->smUtil : 0 },
+            { "mem", own ? own->memUtil : 0 },
+            { "enc", own ? own->encUtil : 0 },
+            { "dec", own ? own->decUtil : 0 },
+        };
+        info.engine_count = 0;
+        for (auto& e : engines) {
+            gpu_engine_load& load = info.engines[info.engine_count++];
+            snprintf(load.name, sizeof(load.name), "%s", e.name);
+            load.percent = e.value;
+        }
+        info.load = own ? own->smUtil : 0;
+    } else if (ret != NVML_ERROR_NOT_FOUND) {
+        // NOT_FOUND only means no new samples since the last call
+        return false;
+    }
+
+    count = procs.size();
+    ret = nvml.nvmlDeviceGetGraphicsRunningProcesses(nvidiaDevice, &count, procs.data());
+    if (ret == NVML_ERROR_INSUFFICIENT_SIZE) {
+        procs.resize(count);
+        ret = nvml.nvmlDeviceGetGraphicsRunningProcesses(nvidiaDevice, &count, procs.data());
+    }
+    info.memoryUsed = 0;
+    if (ret == NVML_SUCCESS) {
+        for (unsigned i = 0; i < count; i++)
+            if (procs[i].pid == pid && procs[i].usedGpuMemory != (unsigned long long)NVML_VALUE_NOT_AVAILABLE)
+                info.memoryUsed += procs[i].usedGpuMemory / (1024.f * 1024.f * 1024.f);
     }
-    
-    return false;
+
+    info.valid = true;
+    return true;
 }
 
-bool getNVMLInfo(){
-    nvmlReturn_t response;
+unsigned getNVMLThrottleReasons(){
+    unsigned long long nv = 0;
     auto& nvml = get_libnvml_loader();
-    response = nvml.nvmlDeviceGetUtilizationRates(nvidiaDevice, &nvidiaUtilization);
-    nvml.nvmlDeviceGetTemperature(nvidiaDevice, NVML_TEMPERATURE_GPU, &nvidiaTemp);
-    nvml.nvmlDeviceGetMemoryInfo(nvidiaDevice, &nvidiaMemory);
-    nvml.nvmlDeviceGetClockInfo(nvidiaDevice, NVML_CLOCK_GRAPHICS, &nvidiaCoreClock);
-    nvml.nvmlDeviceGetClockInfo(nvidiaDevice, NVML_CLOCK_MEM, &nvidiaMemClock);
-    nvml.nvmlDeviceGetPowerUsage(nvidiaDevice, &nvidiaPowerUsage);
-    deviceID = nvidiaPciInfo.pciDeviceId >> 16;
-
-    if (response == NVML_ERROR_NOT_SUPPORTED)
-        nvmlSuccess = false;
-    return nvmlSuccess;
+    if (nvml.nvmlDeviceGetCurrentClocksThrottleReasons(nvidiaDevice, &nv) != NVML_SUCCESS)
+        return 0;
+
+    // idle, application clocks, sync boost and display clocks are not throttling
+    unsigned reasons = 0;
+    if (nv & (nvmlClocksThrottleReasonSwPowerCap | nvmlClocksThrottleReasonHwPowerBrakeSlowdown))
+        reasons |= THROTTLE_POWER;
+    if (nv & (nvmlClocksThrottleReasonSwThermalSlowdown | nvmlClocksThrottleReasonHwThermalSlowdown))
+        reasons |= THROTTLE_THERMAL;
+    // HW slowdown is raised by either power brake or temperature
+    if (nv & nvmlClocksThrottleReasonHwSlowdown)
+        reasons |= THROTTLE_OTHER;
+    return reasons;
+}
+
+static unsigned nvml_sample_value(nvmlValueType_t type, const nvmlValue_t& value){
+    switch (type) {
+    case NVML_VALUE_TYPE_DOUBLE:             return value.dVal;
+    case NVML_VALUE_TYPE_UNSIGNED_LONG:      return value.ulVal;
+    case NVML_VALUE_TYPE_UNSIGNED_LONG_LONG: return value.ullVal;
+    case NVML_VALUE_TYPE_SIGNED_LONG_LONG:   return value.sllVal;
+    default:                                 return value.uiVal;
+    }
+}
+
+// The driver samples utilization and clocks on its own, several times per
+// fps_sampling_period. Every type has its own timestamps, the utilization
+// samples make the timeline and the others are carried forward to them.
+unsigned getNVMLSamples(struct gpu_sample *out, unsigned max){
+    static const nvmlSamplingType_t types[] = {
+        NVML_GPU_UTILIZATION_SAMPLES,
+        NVML_MEMORY_UTILIZATION_SAMPLES,
+        NVML_PROCESSOR_CLK_SAMPLES,
+        NVML_MEMORY_CLK_SAMPLES,
+    };
+    static const unsigned type_count = sizeof(types) / sizeof(types[0]);
+    static unsigned long long lastSeen[type_count] {};
+    static std::vector<nvmlSample_t> buf;
+    static struct gpu_sample current {};
+    auto& nvml = get_libnvml_loader();
+
+    struct event { unsigned long long timeStamp; unsigned type; unsigned value; };
+    std::vector<event> events;
+
+    for (unsigned t = 0; t < type_count; t++) {
+        nvmlValueType_t valType;
+        unsigned int count = 0;
+        if (buf.empty()) {
+            // the size of the driver's buffer, the same for all types
+            if (nvml.nvmlDeviceGetSamples(nvidiaDevice, types[t], 0, &valType, &count, nullptr) != NVML_SUCCESS || !count)
+                return 0;
+            buf.resize(count);
+        }
+
+        count = buf.size();
+        // NOT_FOUND only means no new samples since the last call
+        if (nvml.nvmlDeviceGetSamples(nvidiaDevice, types[t], lastSeen[t], &valType, &count, buf.data()) != NVML_SUCCESS)
+            continue;
+
+        for (unsigned i = 0; i < count; i++) {
+            if (buf[i].timeStamp <= lastSeen[t])
+                continue;
+            events.push_back({buf[i].timeStamp, t, nvml_sample_value(valType, buf[i].sampleValue)});
+        }
+        for (unsigned i = 0; i < count; i++)
+            lastSeen[t] = std::max(lastSeen[t], buf[i].timeStamp);
+    }
+
+    // clocks and memory load of the same instant go in before the utilization
+    std::sort(events.begin(), events.end(), [](const event& a, const event& b) {
+        return a.timeStamp != b.timeStamp ? a.timeStamp < b.timeStamp : a.type > b.type;
+    });
+
+    unsigned total = 0;
+    for (auto& e : events) {
+        switch (e.type) {
+        case 0: current.load = e.value; break;
+        case 1: current.mem_load = e.value; break;
+        case 2: current.CoreClock = e.value; break;
+        case 3: current.MemClock = e.value; break;
+        }
+        if (e.type != 0)
+            continue;
+        current.timestamp = e.timeStamp;
+        // keeps the newest max of them
+        out[total % max] = current;
+        total++;
+    }
+
+    if (total > max)
+        std::rotate(out, out + total % max, out + max);
+    return std::min(total, max);
 }
@@ -6,7 +6,11 @@
 #include "cpu.h"
 #include "gpu.h"
 #include "memory.h"
+#include "sampler.h"
 #include "timing.hpp"
+#ifdef __gnu_linux__
+#include "thread_stats.h"
+#endif
 #include "mesa/util/macros.h"
 #include "string_utils.h"
 #ifdef HAVE_DBUS
@@ -18,56 +22,8 @@ struct benchmark_stats benchmark;
 struct fps_limit fps_limit_stats {};
 ImVec2 real_font_size;
 std::vector<logData> graph_data;
-
-void update_hw_info(struct swapchain_stats& sw_stats, struct overlay_params& params, uint32_t vendorID)
-{
-   if (params.enabled[OVERLAY_PARAM_ENABLED_cpu_stats] || logger->is_active()) {
-      cpuStats.UpdateCPUData();
-#ifdef __gnu_linux__
-
-      if (params.enabled[OVERLAY_PARAM_ENABLED_core_load] || params.enabled[OVERLAY_PARAM_ENABLED_cpu_mhz])
-         cpuStats.UpdateCoreMhz();
-      if (params.enabled[OVERLAY_PARAM_ENABLED_cpu_temp] || logger->is_active() || params.enabled[OVERLAY_PARAM_ENABLED_graphs])
-         cpuStats.UpdateCpuTemp();
-      if (params.enabled[OVERLAY_PARAM_ENABLED_cpu_power])
-         cpuStats.UpdateCpuPower();
-#endif
-   }
-   if (params.enabled[OVERLAY_PARAM_ENABLED_gpu_stats] || logger->is_active()) {
-      if (vendorID == 0x1002)
-         getAmdGpuInfo();
-
-      if (vendorID == 0x10de)
-         getNvidiaGpuInfo();
-   }
-
-   // get ram usage/max
-
-#ifdef __gnu_linux__
-   if (params.enabled[OVERLAY_PARAM_ENABLED_ram] || logger->is_active())
-      update_meminfo();
-   if (params.enabled[OVERLAY_PARAM_ENABLED_io_read] || params.enabled[OVERLAY_PARAM_ENABLED_io_write])
-      getIoStats(&sw_stats.io);
-#endif
-
-   currentLogData.gpu_load = gpu_info.load;
-   currentLogData.gpu_temp = gpu_info.temp;
-   currentLogData.gpu_core_clock = gpu_info.CoreClock;
-   currentLogData.gpu_mem_clock = gpu_info.MemClock;
-   currentLogData.gpu_vram_used = gpu_info.memoryUsed;
-#ifdef __gnu_linux__
-   currentLogData.ram_used = memused;
-#endif
-
-   currentLogData.cpu_load = cpuStats.GetCPUDataTotal().percent;
-   currentLogData.cpu_temp = cpuStats.GetCPUDataTotal().temp;
-   // Save data for graphs
-   if (graph_data.size() > 50)
-      graph_data.erase(graph_data.begin());
-   graph_data.push_back({0, 0, cpuStats.GetCPUDataTotal().percent, gpu_info.load, cpuStats.GetCPUDataTotal().temp,
-                        gpu_info.temp, gpu_info.CoreClock, gpu_info.MemClock, gpu_info.memoryUsed, memused});
-   logger->notify_data_valid();
-}
+std::vector<gpu_sample> gpu_sample_data;
+std::vector<float> psi_graph_data[PSI_MAX];
 
 void update_hud_info(struct swapchain_stats& sw_stats, struct overlay_params& params, uint32_t vendorID){
    uint32_t f_idx = sw_stats.n_frames % ARRAY_SIZE(sw_stats.frames_stats);
@@ -83,9 +39,25 @@ void update_hud_info(struct swapchain_stats& sw_stats, struct overlay_params& pa
    }
 
    frametime = now - sw_stats.last_present_time;
+
+#ifdef __gnu_linux__
+   // called on the thread that presents, time it spent runnable but not running
+   if (params.enabled[OVERLAY_PARAM_ENABLED_runqueue_wait]) {
+      SchedDelta sched;
+      presentSchedStat.Sample(sched);
+      runqueue_wait = sched.wait / 1000; /* us */
+      sw_stats.frames_stats[f_idx].stats[OVERLAY_PLOTS_runqueue_wait] = runqueue_wait;
+      sw_stats.runqueue_wait_sum += sched.wait;
+   }
+#endif
    if (elapsed >= params.fps_sampling_period) {
-      std::thread(update_hw_info, std::ref(sw_stats), std::ref(params), vendorID).detach();
+      if (!hw_sampler.is_running())
+         hw_sampler.start(params);
+      hw_sampler.tick();
       sw_stats.fps = fps;
+      if (sw_stats.n_frames_since_update)
+         sw_stats.runqueue_wait = sw_stats.runqueue_wait_sum / 1000000.0 / sw_stats.n_frames_since_update;
+      sw_stats.runqueue_wait_sum = 0;
 
       if (params.enabled[OVERLAY_PARAM_ENABLED_time]) {
          std::time_t t = std::time(nullptr);
@@ -99,6 +71,25 @@ void update_hud_info(struct swapchain_stats& sw_stats, struct overlay_params& pa
 
    }
 
+   if (telemetry.load_if_newer(HUDElements.telemetry, HUDElements.telemetry_version)) {
+      const telemetry_snapshot& t = HUDElements.telemetry;
+      // Save data for graphs
+      if (graph_data.size() > 50)
+         graph_data.erase(graph_data.begin());
+      graph_data.push_back({0, 0, t.cpu.percent, t.gpu.load, t.cpu.temp, t.gpu.temp,
+                           t.gpu.CoreClock, t.gpu.MemClock, t.gpu.memoryUsed, t.ram_used, {}});
+      for (int r = 0; r < PSI_MAX; r++) {
+         if (psi_graph_data[r].size() > 50)
+            psi_graph_data[r].erase(psi_graph_data[r].begin());
+         psi_graph_data[r].push_back(t.psi[r].some.avg10);
+      }
+      for (unsigned i = 0; i < t.gpu_sample_count; i++) {
+         if (gpu_sample_data.size() > 50)
+            gpu_sample_data.erase(gpu_sample_data.begin());
+         gpu_sample_data.push_back(t.gpu_samples[i]);
+      }
+   }
+
    if (params.log_interval == 0){
       logger->try_log();
    }
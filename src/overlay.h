@@ -7,7 +7,7 @@
 #include <vector>
 #include "imgui.h"
 #include "overlay_params.h"
-#include "iostats.h"
+#include "telemetry.h"
 #include "timing.hpp"
 #include "hud_elements.h"
 #include "version.h"
@@ -33,10 +33,12 @@ struct swapchain_stats {
    size_t font_params_hash = 0;
    std::string time;
    double fps;
-   struct iostats io;
    uint64_t last_present_time;
    unsigned n_frames_since_update;
    uint64_t last_fps_update;
+   // ns the presenting thread waited for a CPU, summed since the last fps update
+   uint64_t runqueue_wait_sum = 0;
+   double runqueue_wait = 0; /* ms per frame */
    ImVec2 main_window_pos;
 
    struct {
@@ -79,18 +81,20 @@ struct LOAD_DATA {
 };
 
 extern struct fps_limit fps_limit_stats;
-extern int32_t deviceID;
 
 extern struct benchmark_stats benchmark;
 extern ImVec2 real_font_size;
 extern std::string wineVersion;
 extern std::vector<logData> graph_data;
+extern std::vector<gpu_sample> gpu_sample_data;
+// some avg10 of each resource, for the psi graphs
+extern std::vector<float> psi_graph_data[PSI_MAX];
 
 void position_layer(struct swapchain_stats& data, struct overlay_params& params, ImVec2 window_size);
 void render_imgui(swapchain_stats& data, struct overlay_params& params, ImVec2& window_size, bool is_vulkan);
 void update_hud_info(struct swapchain_stats& sw_stats, struct overlay_params& params, uint32_t vendorID);
-void update_hw_info(struct swapchain_stats& sw_stats, struct overlay_params& params, uint32_t vendorID);
-void init_gpu_stats(uint32_t& vendorID, overlay_params& params);
+// device_pci is the PCI address of the GPU the app renders on, if known
+void init_gpu_stats(uint32_t vendorID, overlay_params& params, const std::string& device_pci);
 void init_cpu_stats(overlay_params& params);
 void check_keybinds(struct swapchain_stats& sw_stats, struct overlay_params& params, uint32_t vendorID);
 void init_system_info(void);
@@ -279,6 +279,24 @@ parse_media_player_order(const char *str)
 }
 
 
+static std::vector<core_load_group>
+parse_core_load_group(const char *str)
+{
+   std::vector<core_load_group> groups;
+   auto tokens = str_tokenize(str);
+   for (auto& token : tokens) {
+      trim(token);
+      std::transform(token.begin(), token.end(), token.begin(), ::tolower);
+      if (token == "core" || token == "smt")
+         groups.push_back(CORE_LOAD_GROUP_CORE);
+      else if (token == "l3")
+         groups.push_back(CORE_LOAD_GROUP_L3);
+      else if (token == "type")
+         groups.push_back(CORE_LOAD_GROUP_TYPE);
+   }
+   return groups;
+}
+
 static std::vector<std::string>
 parse_benchmark_percentiles(const char *str)
 {
@@ -379,6 +397,7 @@ parse_font_glyph_ranges(const char *str)
 #define parse_no_small_font(s) parse_unsigned(s) != 0
 #define parse_cellpadding_y(s) parse_float(s)
 #define parse_table_columns(s) parse_unsigned(s)
+#define parse_thread_load_count(s) parse_unsigned(s)
 #define parse_autostart_log(s) parse_unsigned(s)
 
 #define parse_cpu_color(s) parse_color(s)
@@ -396,6 +415,7 @@ parse_font_glyph_ranges(const char *str)
 #define parse_cpu_load_color(s) parse_load_color(s)
 #define parse_gpu_load_value(s) parse_load_value(s)
 #define parse_cpu_load_value(s) parse_load_value(s)
+#define parse_gpu_list(s) parse_load_value(s)
 #define parse_blacklist(s) parse_str_tokenize(s)
 
 static bool
@@ -538,6 +558,20 @@ parse_overlay_config(struct overlay_params *params,
    params->enabled[OVERLAY_PARAM_ENABLED_cpu_load_change] = false;
    params->enabled[OVERLAY_PARAM_ENABLED_legacy_layout] = true;
    params->enabled[OVERLAY_PARAM_ENABLED_frametime] = true;
+   params->enabled[OVERLAY_PARAM_ENABLED_sampler_stats] = false;
+   params->enabled[OVERLAY_PARAM_ENABLED_sensor_cache] = false;
+   params->enabled[OVERLAY_PARAM_ENABLED_thread_load] = false;
+   params->enabled[OVERLAY_PARAM_ENABLED_proc_gpu_stats] = false;
+   params->enabled[OVERLAY_PARAM_ENABLED_procmem] = false;
+   params->enabled[OVERLAY_PARAM_ENABLED_psi] = false;
+   params->enabled[OVERLAY_PARAM_ENABLED_psi_cgroup] = false;
+   params->enabled[OVERLAY_PARAM_ENABLED_runqueue_wait] = false;
+   params->enabled[OVERLAY_PARAM_ENABLED_page_faults] = false;
+   params->enabled[OVERLAY_PARAM_ENABLED_throttling_status] = false;
+   params->enabled[OVERLAY_PARAM_ENABLED_disk_stats] = false;
+   params->enabled[OVERLAY_PARAM_ENABLED_nvml_samples] = false;
+   params->enabled[OVERLAY_PARAM_ENABLED_cstates] = false;
+   params->enabled[OVERLAY_PARAM_ENABLED_cpu_power_domains] = false;
    params->fps_sampling_period = 500000; /* 500ms */
    params->width = 0;
    params->height = 140;
@@ -573,6 +607,7 @@ parse_overlay_config(struct overlay_params *params,
    params->gpu_load_value = { 60, 90 };
    params->cpu_load_value = { 60, 90 };
    params->cellpadding_y = -0.085;
+   params->thread_load_count = 5;
 
 
 
@@ -681,6 +716,8 @@ parse_overlay_config(struct overlay_params *params,
    if (!params->table_columns)
       params->table_columns = 3;
 
+   params->thread_load_count = std::min(params->thread_load_count, (unsigned)MAX_TOP_THREADS);
+
    if (!params->font_size) {
       params->font_size = 24;
    }
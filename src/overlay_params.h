@@ -58,6 +58,20 @@ typedef unsigned long KeySym;
    OVERLAY_PARAM_BOOL(legacy_layout)                 \
    OVERLAY_PARAM_BOOL(cpu_mhz)                       \
    OVERLAY_PARAM_BOOL(frametime)                     \
+   OVERLAY_PARAM_BOOL(sampler_stats)                 \
+   OVERLAY_PARAM_BOOL(sensor_cache)                  \
+   OVERLAY_PARAM_BOOL(thread_load)                   \
+   OVERLAY_PARAM_BOOL(proc_gpu_stats)                \
+   OVERLAY_PARAM_BOOL(procmem)                       \
+   OVERLAY_PARAM_BOOL(psi)                           \
+   OVERLAY_PARAM_BOOL(psi_cgroup)                    \
+   OVERLAY_PARAM_BOOL(runqueue_wait)                 \
+   OVERLAY_PARAM_BOOL(page_faults)                   \
+   OVERLAY_PARAM_BOOL(throttling_status)             \
+   OVERLAY_PARAM_BOOL(disk_stats)                    \
+   OVERLAY_PARAM_BOOL(nvml_samples)                  \
+   OVERLAY_PARAM_BOOL(cstates)                       \
+   OVERLAY_PARAM_BOOL(cpu_power_domains)             \
    OVERLAY_PARAM_CUSTOM(fps_sampling_period)         \
    OVERLAY_PARAM_CUSTOM(output_folder)               \
    OVERLAY_PARAM_CUSTOM(output_file)                 \
@@ -117,6 +131,9 @@ typedef unsigned long KeySym;
    OVERLAY_PARAM_CUSTOM(cpu_load_color)              \
    OVERLAY_PARAM_CUSTOM(cellpadding_y)               \
    OVERLAY_PARAM_CUSTOM(table_columns)               \
+   OVERLAY_PARAM_CUSTOM(thread_load_count)           \
+   OVERLAY_PARAM_CUSTOM(gpu_list)                    \
+   OVERLAY_PARAM_CUSTOM(core_load_group)             \
    OVERLAY_PARAM_CUSTOM(blacklist)                   \
    OVERLAY_PARAM_CUSTOM(autostart_log)               \
 
@@ -130,6 +147,7 @@ enum overlay_param_position {
 
 enum overlay_plots {
     OVERLAY_PLOTS_frame_timing,
+    OVERLAY_PLOTS_runqueue_wait,
     OVERLAY_PLOTS_MAX,
 };
 
@@ -139,6 +157,14 @@ enum media_player_order {
    MP_ORDER_ALBUM,
 };
 
+// how core_load aggregates the CPUs, a flat list when none is given
+enum core_load_group {
+   CORE_LOAD_GROUP_CORE,   // SMT siblings
+   CORE_LOAD_GROUP_L3,
+   CORE_LOAD_GROUP_TYPE,   // P/E cores
+   CORE_LOAD_GROUP_MAX,
+};
+
 enum font_glyph_ranges {
    FG_KOREAN                  = (1u << 0),
    FG_CHINESE_FULL            = (1u << 1),
@@ -181,8 +207,10 @@ struct overlay_params {
    std::vector<unsigned> cpu_load_color;
    std::vector<unsigned> gpu_load_value;
    std::vector<unsigned> cpu_load_value;
+   std::vector<unsigned> gpu_list;
    unsigned media_player_color;
    unsigned table_columns;
+   unsigned thread_load_count;
    bool no_small_font;
    float font_size, font_scale;
    float font_size_text;
@@ -203,6 +231,7 @@ struct overlay_params {
    std::vector<std::string> blacklist;
    unsigned log_interval, autostart_log;
    std::vector<media_player_order> media_player_order;
+   std::vector<core_load_group> core_load_group;
    std::vector<std::string> benchmark_percentiles;
    std::string font_file, font_file_text;
    uint32_t font_glyph_ranges;
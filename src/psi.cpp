@@ -0,0 +1,95 @@
+#include "psi.h"
+#include <cstring>
+#include <cstdlib>
+#include <iostream>
+#include <fstream>
+#include "file_utils.h"
+
+PsiStats psiStats;
+const char *psi_resource_names[PSI_MAX] = { "cpu", "io", "memory" };
+
+// cgroup v2 path of the process, empty when only v1 is mounted
+static std::string get_cgroup_path()
+{
+    std::ifstream file("/proc/self/cgroup");
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.compare(0, 3, "0::") == 0)
+            return "/sys/fs/cgroup" + line.substr(3);
+    }
+    return std::string();
+}
+
+bool PsiStats::Init(bool cgroup)
+{
+    m_inited = true;
+
+    std::string dir = "/proc/pressure/";
+    std::string suffix;
+    if (cgroup) {
+        std::string path = get_cgroup_path();
+        if (!path.empty() && file_exists(path + "/cpu.pressure")) {
+            dir = path + "/";
+            suffix = ".pressure";
+        } else {
+            std::cerr << "MANGOHUD: No cgroup v2 pressure files, using system wide PSI\n";
+        }
+    }
+
+    bool found = false;
+    for (int i = 0; i < PSI_MAX; i++) {
+        // a line is about 60 bytes
+        m_idx[i] = m_counters.add(dir + psi_resource_names[i] + suffix, 160);
+        found |= m_idx[i] >= 0;
+    }
+
+    if (!found)
+        std::cerr << "MANGOHUD: Pressure stall information is not available, needs CONFIG_PSI\n";
+    return found;
+}
+
+// "some avg10=1.23 avg60=0.50 avg300=0.10 total=123456"
+bool PsiStats::ParseLine(const char *text, const char *kind, float& avg10, uint64_t& total) const
+{
+    const char *line = strstr(text, kind);
+    if (!line)
+        return false;
+
+    const char *p = strstr(line, "avg10=");
+    const char *t = strstr(line, "total=");
+    const char *end = strchr(line, '\n');
+    if (!p || !t || (end && t > end))
+        return false;
+
+    avg10 = strtof(p + 6, nullptr);
+    total = strtoull(t + 6, nullptr, 10);
+    return true;
+}
+
+bool PsiStats::Update()
+{
+    if (m_counters.empty())
+        return false;
+
+    m_counters.update();
+    for (int i = 0; i < PSI_MAX; i++) {
+        psi_sample& s = m_samples[i];
+        const char *text = m_counters.text(m_idx[i]);
+        psi_stall *stalls[2] = { &s.some, &s.full };
+        const char *kinds[2] = { "some", "full" };
+
+        s.valid = false;
+        for (int k = 0; k < 2; k++) {
+            uint64_t total;
+            // no full line for cpu before 5.13
+            if (!ParseLine(text, kinds[k], stalls[k]->avg10, total)) {
+                *stalls[k] = {};
+                continue;
+            }
+            stalls[k]->delta = m_lastTotal[i][k] && total >= m_lastTotal[i][k] ? total - m_lastTotal[i][k] : 0;
+            m_lastTotal[i][k] = total;
+            s.valid = true;
+        }
+    }
+    return true;
+}
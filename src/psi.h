@@ -0,0 +1,55 @@
+#pragma once
+#ifndef MANGOHUD_PSI_H
+#define MANGOHUD_PSI_H
+
+#include <stdint.h>
+#include <string>
+#include "sysfs_counters.h"
+
+class io_uring_reader;
+
+enum psi_resource {
+    PSI_CPU,
+    PSI_IO,
+    PSI_MEMORY,
+    PSI_MAX,
+};
+
+// One line of a pressure file, avg10 in % and the stalled time since the
+// previous update in us
+struct psi_stall {
+    float avg10;
+    uint64_t delta;
+};
+
+struct psi_sample {
+    bool valid;
+    struct psi_stall some, full;
+};
+
+// Pressure Stall Information of the whole system, or of the cgroup the
+// process runs in
+class PsiStats
+{
+public:
+    bool Init(bool cgroup);
+    bool Update();
+    void Queue(io_uring_reader& reader) { m_counters.queue(reader); }
+    bool IsInitialized() const { return m_inited; }
+
+    const psi_sample& Get(psi_resource res) const { return m_samples[res]; }
+
+private:
+    bool ParseLine(const char *text, const char *kind, float& avg10, uint64_t& total) const;
+
+    counter_set m_counters;
+    int m_idx[PSI_MAX] = { -1, -1, -1 };
+    uint64_t m_lastTotal[PSI_MAX][2] {};
+    psi_sample m_samples[PSI_MAX] {};
+    bool m_inited = false;
+};
+
+extern PsiStats psiStats;
+extern const char *psi_resource_names[PSI_MAX];
+
+#endif //MANGOHUD_PSI_H
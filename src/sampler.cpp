@@ -0,0 +1,450 @@
+#include "sampler.h"
+#include <algorithm>
+#include <cstdlib>
+#include "overlay.h"
+#include "logging.h"
+#include "cpu.h"
+#include "cpu_topology.h"
+#include "gpu.h"
+#include "gpu_backend.h"
+#include "memory.h"
+#ifdef __gnu_linux__
+#include "thread_stats.h"
+#include "psi.h"
+#include "faults.h"
+#include "throttle.h"
+#include "diskstats.h"
+#include "cpuidle.h"
+#endif
+#include "telemetry.h"
+#include "timing.hpp"
+
+HwSampler hw_sampler;
+seqlock<telemetry_snapshot> telemetry;
+
+static bool logging_active()
+{
+   return logger && logger->is_active();
+}
+
+static bool cpu_enabled(const HwSampler& s)
+{
+   return s.params().enabled[OVERLAY_PARAM_ENABLED_cpu_stats] || logging_active();
+}
+
+static bool gpu_enabled(const HwSampler& s)
+{
+   return s.params().enabled[OVERLAY_PARAM_ENABLED_gpu_stats] || logging_active();
+}
+
+HwSampler::HwSampler()
+{
+   m_sources = {
+      { "cpu_load", 1,
+         cpu_enabled,
+         [](HwSampler&) { cpuStats.UpdateCPUData(); },
+#ifdef __gnu_linux__
+         [](HwSampler&, io_uring_reader& r) { cpuStats.QueueCPUData(r); },
+#endif
+      },
+#ifdef __gnu_linux__
+      { "cpu_mhz", 1,
+         [](const HwSampler& s) {
+            return cpu_enabled(s)
+               && (s.params().enabled[OVERLAY_PARAM_ENABLED_core_load]
+                  || s.params().enabled[OVERLAY_PARAM_ENABLED_cpu_mhz]);
+         },
+         [](HwSampler&) { cpuStats.UpdateCoreMhz(); },
+         [](HwSampler&, io_uring_reader& r) { cpuStats.QueueCoreMhz(r); } },
+      // hwmon temperature inputs rarely refresh faster than once a second
+      { "cpu_temp", 2,
+         [](const HwSampler& s) {
+            return cpu_enabled(s)
+               && (s.params().enabled[OVERLAY_PARAM_ENABLED_cpu_temp]
+                  || logging_active()
+                  || s.params().enabled[OVERLAY_PARAM_ENABLED_graphs]);
+         },
+         [](HwSampler&) { cpuStats.UpdateCpuTemp(); },
+         [](HwSampler&, io_uring_reader& r) { cpuStats.QueueCpuTemp(r); } },
+      { "cpu_power", 1,
+         [](const HwSampler& s) {
+            return cpu_enabled(s) && (s.params().enabled[OVERLAY_PARAM_ENABLED_cpu_power]
+                                      || s.params().enabled[OVERLAY_PARAM_ENABLED_cpu_power_domains]);
+         },
+         [](HwSampler&) { cpuStats.UpdateCpuPower(); },
+         [](HwSampler&, io_uring_reader& r) { cpuStats.QueueCpuPower(r); } },
+#endif
+      // every sampled GPU, whatever backend they use, the sysfs reads of
+      // all of them go out in the same batch
+      { "gpu", 1,
+         [](const HwSampler& s) { return gpus.ready() && !gpus.empty() && gpu_enabled(s); },
+         [](HwSampler& s) {
+            gpus.update();
+            if (s.vendor_id() == 0x10de && s.params().enabled[OVERLAY_PARAM_ENABLED_nvml_samples])
+               getNvidiaGpuSamples();
+         },
+#ifdef __gnu_linux__
+         [](HwSampler&, io_uring_reader& r) { gpus.queue(r); },
+#endif
+      },
+#ifdef __gnu_linux__
+      { "ram", 2,
+         [](const HwSampler& s) {
+            return s.params().enabled[OVERLAY_PARAM_ENABLED_ram] || logging_active();
+         },
+         [](HwSampler&) { update_meminfo(); },
+         [](HwSampler&, io_uring_reader& r) { queue_meminfo(r); } },
+      // walks all mappings of the process in the kernel, every other second
+      { "procmem", 4,
+         [](const HwSampler& s) { return s.params().enabled[OVERLAY_PARAM_ENABLED_procmem]; },
+         [](HwSampler&) { update_procmem(); },
+         nullptr },
+      // HUD divides the byte deltas by fps_sampling_period, keep it at every tick
+      { "io", 1,
+         [](const HwSampler& s) {
+            return s.params().enabled[OVERLAY_PARAM_ENABLED_io_read]
+               || s.params().enabled[OVERLAY_PARAM_ENABLED_io_write];
+         },
+         [](HwSampler& s) { getIoStats(&s.io); },
+         [](HwSampler&, io_uring_reader& r) { queue_io_stats(r); } },
+      // rates are over the time between updates, not fps_sampling_period
+      { "disk", 1,
+         [](const HwSampler& s) { return s.params().enabled[OVERLAY_PARAM_ENABLED_disk_stats]; },
+         [](HwSampler&) {
+            if (!diskStats.IsInitialized())
+               diskStats.Init();
+            diskStats.Update();
+         },
+         [](HwSampler&, io_uring_reader& r) { diskStats.Queue(r); } },
+      // this process' share of the GPU, next to the device totals
+      { "gpu_proc", 1,
+         [](const HwSampler& s) { return s.params().enabled[OVERLAY_PARAM_ENABLED_proc_gpu_stats]; },
+         [](HwSampler& s) { getGpuProcInfo(s.vendor_id(), s.params().pci_dev); },
+         nullptr },
+      { "psi", 1,
+         [](const HwSampler& s) { return s.params().enabled[OVERLAY_PARAM_ENABLED_psi]; },
+         [](HwSampler& s) {
+            if (!psiStats.IsInitialized())
+               psiStats.Init(s.params().enabled[OVERLAY_PARAM_ENABLED_psi_cgroup]);
+            psiStats.Update();
+         },
+         [](HwSampler&, io_uring_reader& r) { psiStats.Queue(r); } },
+      { "faults", 1,
+         [](const HwSampler& s) { return s.params().enabled[OVERLAY_PARAM_ENABLED_page_faults]; },
+         [](HwSampler& s) { getFaultStats(s.faults_total, s.faults); },
+         [](HwSampler&, io_uring_reader& r) { queue_fault_stats(r); } },
+      { "throttle", 1,
+         [](const HwSampler& s) { return s.params().enabled[OVERLAY_PARAM_ENABLED_throttling_status]; },
+         [](HwSampler& s) {
+            if (s.vendor_id() == 0x10de)
+               getNvidiaThrottleReasons();
+            if (!cpuThrottle.IsInitialized())
+               cpuThrottle.Init();
+            cpuThrottle.Update();
+         },
+         [](HwSampler&, io_uring_reader& r) { cpuThrottle.Queue(r); } },
+      // two files per state and CPU, all in the batch of the pass
+      { "cstates", 1,
+         [](const HwSampler& s) { return s.params().enabled[OVERLAY_PARAM_ENABLED_cstates]; },
+         [](HwSampler&) {
+            if (!cpuIdleStats.IsInitialized())
+               cpuIdleStats.Init();
+            cpuIdleStats.Update();
+         },
+         [](HwSampler&, io_uring_reader& r) { cpuIdleStats.Queue(r); } },
+      // one pread per thread, the task list is only rescanned for new tids
+      { "threads", 1,
+         [](const HwSampler& s) { return s.params().enabled[OVERLAY_PARAM_ENABLED_thread_load]; },
+         [](HwSampler&) { threadStats.Update(); },
+         nullptr },
+#endif
+   };
+}
+
+HwSampler::~HwSampler()
+{
+   stop();
+}
+
+// Apps often exit without tearing the HUD down. Registered on the first
+// start, after the globals the sampler reads were constructed, so this runs
+// before they are destroyed.
+static void stop_at_exit()
+{
+   hw_sampler.stop();
+}
+
+void HwSampler::start(overlay_params& params)
+{
+   if (is_running())
+      return;
+
+   static bool exit_registered = false;
+   if (!exit_registered) {
+      atexit(stop_at_exit);
+      exit_registered = true;
+   }
+
+   m_params = &params;
+   m_quit = false;
+   for (auto& src : m_sources)
+      src.ticks = 0;
+   m_thread = std::thread(&HwSampler::run, this);
+}
+
+uint32_t HwSampler::vendor_id() const
+{
+   return gpus.vendor_id();
+}
+
+void HwSampler::stop()
+{
+   if (!is_running())
+      return;
+
+   {
+      std::lock_guard<std::mutex> lk(m_mutex);
+      m_quit = true;
+   }
+   m_cv.notify_all();
+   m_thread.join();
+}
+
+void HwSampler::tick()
+{
+   {
+      std::lock_guard<std::mutex> lk(m_mutex);
+      m_pending = true;
+   }
+   m_cv.notify_one();
+}
+
+void HwSampler::update_all()
+{
+   {
+      std::lock_guard<std::mutex> lk(m_mutex);
+      m_pending = true;
+      m_all = true;
+   }
+   m_cv.notify_one();
+}
+
+void sampler_cost::add(uint64_t ns)
+{
+   samples[next] = std::min<uint64_t>(ns, UINT32_MAX);
+   next = (next + 1) % SAMPLER_COST_WINDOW;
+   if (count < SAMPLER_COST_WINDOW)
+      count++;
+}
+
+void sampler_cost::get(struct telemetry_cost& cost) const
+{
+   cost.min = cost.avg = cost.max = 0;
+   if (!count)
+      return;
+
+   uint32_t min = UINT32_MAX, max = 0;
+   uint64_t sum = 0;
+   for (unsigned i = 0; i < count; i++) {
+      min = std::min(min, samples[i]);
+      max = std::max(max, samples[i]);
+      sum += samples[i];
+   }
+   cost.min = min / 1000.f;
+   cost.avg = sum / 1000.f / count;
+   cost.max = max / 1000.f;
+}
+
+void HwSampler::run()
+{
+#ifdef __gnu_linux__
+   m_reader.init();
+#endif
+
+   std::unique_lock<std::mutex> lk(m_mutex);
+   while (true) {
+      m_cv.wait(lk, [this] { return m_quit || m_pending; });
+      if (m_quit)
+         break;
+
+      bool all = m_all;
+      m_pending = m_all = false;
+
+      lk.unlock();
+      sample(all);
+      lk.lock();
+   }
+}
+
+void HwSampler::sample(bool all)
+{
+   uint64_t pass_start = os_time_get_nano();
+
+   for (auto& src : m_sources) {
+      src.due = false;
+      if (!src.is_enabled(*this))
+         continue;
+
+      // first pass after enabling always samples
+      if (!all && src.ticks > 0 && src.ticks < src.interval) {
+         src.ticks++;
+         continue;
+      }
+
+      src.ticks = 1;
+      src.due = true;
+   }
+
+#ifdef __gnu_linux__
+   // Issue the reads of every due source in one go, the updates below only
+   // parse the results and pread() whatever could not be read that way.
+   if (m_reader.available()) {
+      for (auto& src : m_sources)
+         if (src.due && src.queue)
+            src.queue(*this, m_reader);
+      m_reader.submit();
+   }
+#endif
+
+   for (auto& src : m_sources) {
+      if (!src.due)
+         continue;
+
+      uint64_t start = os_time_get_nano();
+      src.update(*this);
+      src.cost.add(os_time_get_nano() - start);
+   }
+
+   m_pass_cost.add(os_time_get_nano() - pass_start);
+   publish();
+}
+
+// gpu_info, cpuStats and memused are only touched by the sampler thread,
+// the HUD and the logger read the published copy
+void HwSampler::publish()
+{
+   m_snapshot = {};
+   telemetry_snapshot& snap = m_snapshot;
+
+   snap.gpu = gpu_info;
+   snap.gpu_proc = gpu_proc_info;
+   snap.gpu_ready = gpus.ready();
+   for (size_t i = 0; snap.gpu_ready && i < gpus.size(); i++) {
+      if (!gpus.is_sampled(i))
+         continue;
+      telemetry_gpu& g = snap.gpus[snap.gpu_count++];
+      g.index = i;
+      g.primary = (int)i == gpus.primary();
+      g.info = gpus.device(i).info;
+   }
+   // the logger gets every sample, the HUD only those of the passes it sees
+   snap.gpu_sample_count = gpu_sample_count;
+   memcpy(snap.gpu_samples, gpu_samples, sizeof(gpu_samples[0]) * gpu_sample_count);
+   if (gpu_sample_count && logging_active())
+      logger->add_gpu_samples(gpu_samples, gpu_sample_count);
+   gpu_sample_count = 0;
+
+   const CPUData& total = cpuStats.GetCPUDataTotal();
+   snap.cpu.percent = total.percent;
+   snap.cpu.temp = total.temp;
+   snap.cpu.mhz = total.cpu_mhz;
+   snap.cpu.power = cpuStats.GetCPUPower();
+   snap.cpu.energy = cpuStats.GetCPUEnergy();
+
+   const std::vector<CPUData>& cores = cpuStats.GetCPUData();
+   snap.core_count = std::min<size_t>(cores.size(), TELEMETRY_MAX_CORES);
+   for (unsigned i = 0; i < snap.core_count; i++)
+      snap.cores[i] = { cores[i].percent, cores[i].mhz };
+
+#ifdef __gnu_linux__
+   // cores is indexed by CPU number, like the topology
+   if (params().enabled[OVERLAY_PARAM_ENABLED_core_load] && !params().core_load_group.empty()) {
+      if (!cpuTopology.IsInitialized())
+         cpuTopology.Init();
+      for (const cpu_group *group : cpuTopology.Select(params().core_load_group)) {
+         telemetry_cpu_group& g = snap.cpu_groups[snap.cpu_group_count];
+         float sum = 0.f;
+         unsigned n = 0;
+         g.max = 0.f;
+         for (unsigned cpu : group->cpus) {
+            if (cpu >= cores.size())
+               continue;
+            sum += cores[cpu].percent;
+            g.max = std::max(g.max, cores[cpu].percent);
+            n++;
+         }
+         g.avg = n ? sum / n : 0.f;
+         snprintf(g.name, sizeof(g.name), "%s", group->name.c_str());
+         snprintf(g.key, sizeof(g.key), "%s", group->key.c_str());
+         snap.cpu_group_count++;
+      }
+   }
+
+   // subdomains are numbered after their package, there is one of each per package
+   const std::vector<rapl_domain>& rapl = cpuStats.GetRaplDomains();
+   snap.rapl_domain_count = std::min<size_t>(rapl.size(), TELEMETRY_MAX_RAPL_DOMAINS);
+   for (unsigned i = 0; i < snap.rapl_domain_count; i++) {
+      telemetry_rapl_domain& d = snap.rapl_domains[i];
+      if (rapl[i].name.compare(0, 7, "package") == 0)
+         snprintf(d.name, sizeof(d.name), "%s", rapl[i].name.c_str());
+      else
+         snprintf(d.name, sizeof(d.name), "%s-%d", rapl[i].name.c_str(), rapl[i].package);
+      d.power = rapl[i].power;
+   }
+
+   snap.ram_used = memused;
+   snap.ram_total = memmax;
+   snap.procmem = {proc_mem.rss, proc_mem.pss, proc_mem.swap, proc_mem.growth};
+   for (int i = 0; i < PSI_MAX; i++)
+      snap.psi[i] = psiStats.Get((psi_resource)i);
+   snap.io = io;
+   snap.disk = diskStats.Get();
+   snprintf(snap.disk_name, sizeof(snap.disk_name), "%s", diskStats.Name().c_str());
+   snap.cstates = cpuIdleStats.Get();
+   for (unsigned i = 0; i < snap.cstates.count; i++)
+      snprintf(snap.cstate_names[i], sizeof(snap.cstate_names[i]), "%s", cpuIdleStats.Name(i).c_str());
+   // by CPU number, like the cores above
+   const std::vector<cpuidle_core>& idle = cpuIdleStats.GetCores();
+   for (unsigned i = 0; i < snap.core_count && i < idle.size(); i++) {
+      snap.cores[i].idle_deepest = idle[i].deepest;
+      snap.cores[i].idle_rate = idle[i].rate;
+   }
+   snap.faults_total = faults_total;
+   snap.faults = faults;
+   snap.log.cpu_throttle = cpuThrottle.Reasons();
+   snap.sampler_reads = m_reader.last_reads();
+   snap.sampler_syscalls = m_reader.last_syscalls();
+
+   if (m_params->enabled[OVERLAY_PARAM_ENABLED_thread_load]) {
+      const std::vector<ThreadData>& threads = threadStats.GetThreadData();
+      snap.thread_count = std::min<size_t>(threads.size(), m_params->thread_load_count);
+      for (unsigned i = 0; i < snap.thread_count; i++) {
+         top_thread& t = snap.threads[i];
+         memcpy(t.name, threads[i].name, sizeof(t.name));
+         t.count = threads[i].count;
+         t.percent = threads[i].percent;
+      }
+   }
+#endif
+
+   m_pass_cost.get(snap.pass_cost);
+   snap.cost_count = std::min<size_t>(m_sources.size(), SAMPLER_MAX_SOURCES);
+   for (unsigned i = 0; i < snap.cost_count; i++) {
+      snap.costs[i].name = m_sources[i].name;
+      m_sources[i].cost.get(snap.costs[i]);
+   }
+
+   snap.log.gpu_load = gpu_info.load;
+   snap.log.gpu_temp = gpu_info.temp;
+   snap.log.gpu_core_clock = gpu_info.CoreClock;
+   snap.log.gpu_mem_clock = gpu_info.MemClock;
+   snap.log.gpu_vram_used = gpu_info.memoryUsed;
+   snap.log.ram_used = snap.ram_used;
+   snap.log.cpu_load = snap.cpu.percent;
+   snap.log.cpu_temp = snap.cpu.temp;
+   snap.log.gpu_throttle = gpu_info.throttle_reasons;
+
+   telemetry.store(snap);
+   if (logger)
+      logger->notify_data_valid();
+}
@@ -0,0 +1,102 @@
+#pragma once
+#ifndef MANGOHUD_SAMPLER_H
+#define MANGOHUD_SAMPLER_H
+
+#include <stdint.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include "overlay_params.h"
+#include "iostats.h"
+#include "faults.h"
+#include "telemetry.h"
+#ifdef __gnu_linux__
+#include "io_uring_reader.h"
+#endif
+
+class HwSampler;
+
+#define SAMPLER_COST_WINDOW 32
+
+// Durations of the last SAMPLER_COST_WINDOW runs of a sampler step, in ns
+struct sampler_cost {
+   uint32_t samples[SAMPLER_COST_WINDOW];
+   unsigned count;
+   unsigned next;
+
+   void add(uint64_t ns);
+   // min/avg/max in us
+   void get(struct telemetry_cost& cost) const;
+};
+
+struct sampler_source {
+   const char *name;
+   // run on every n-th sampler tick
+   unsigned interval;
+   bool (*is_enabled)(const HwSampler& sampler);
+   void (*update)(HwSampler& sampler);
+#ifdef __gnu_linux__
+   // optional, queues the reads update() is going to do on the batch of the pass
+   void (*queue)(HwSampler& sampler, io_uring_reader& reader);
+#endif
+   unsigned ticks;
+   bool due;
+   sampler_cost cost;
+};
+
+/* Long-lived hardware sampler. The present path only signals a tick every
+ * fps_sampling_period, the sampling itself runs on a single thread so two
+ * passes can never overlap. Ticks that arrive while a pass is still running
+ * are coalesced into one. */
+class HwSampler {
+public:
+   HwSampler();
+   ~HwSampler();
+
+   void start(overlay_params& params);
+   void stop();
+   bool is_running() const { return m_thread.joinable(); }
+
+   // sample the sources that are due
+   void tick();
+   // sample every enabled source on the next pass, e.g. when logging starts
+   void update_all();
+
+   const overlay_params& params() const { return *m_params; }
+   // of the primary GPU, 0 until the GPU probe is done
+   uint32_t vendor_id() const;
+
+   // fixed once constructed, in the order of the cost columns in logs
+   size_t source_count() const { return m_sources.size(); }
+   const char *source_name(size_t idx) const { return m_sources[idx].name; }
+
+   struct iostats io {};
+   struct fault_counters faults_total {};
+   struct fault_counters faults {};
+
+private:
+   void run();
+   void sample(bool all);
+   void publish();
+
+   std::vector<sampler_source> m_sources;
+#ifdef __gnu_linux__
+   io_uring_reader m_reader;
+#endif
+   overlay_params *m_params = nullptr;
+   telemetry_snapshot m_snapshot {};
+   // the whole pass, including the batched reads
+   sampler_cost m_pass_cost {};
+
+   std::thread m_thread;
+   std::mutex m_mutex;
+   std::condition_variable m_cv;
+   bool m_quit = false;
+   bool m_pending = false;
+   bool m_all = false;
+};
+
+extern HwSampler hw_sampler;
+
+#endif //MANGOHUD_SAMPLER_H
@@ -0,0 +1,238 @@
+#include "sensors.h"
+#include "file_utils.h"
+#include "string_utils.h"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <sys/stat.h>
+
+sensor_registry sensors;
+
+static const char *sensor_roots[] = {
+    "/sys/class/hwmon/",
+    "/sys/class/powercap/",
+    "/sys/class/drm/",
+};
+
+static std::string resolve_device(const std::string& path)
+{
+    char buf[PATH_MAX];
+    if (!realpath((path + "/device").c_str(), buf))
+        return std::string();
+    return buf;
+}
+
+static std::vector<std::string> class_entries(sensor_class cls)
+{
+    auto dirs = ls(sensor_roots[cls]);
+    if (cls == SENSOR_DRM) {
+        // only cards, not their connectors or render nodes
+        dirs.erase(std::remove_if(dirs.begin(), dirs.end(), [](const std::string& d) {
+            return !starts_with(d, "card") || d.find('-') != std::string::npos;
+        }), dirs.end());
+    }
+    return dirs;
+}
+
+// unlike str_tokenize, keeps empty fields
+static std::vector<std::string> split_fields(const std::string& line)
+{
+    std::vector<std::string> fields;
+    size_t start = 0, end;
+    while ((end = line.find('\t', start)) != std::string::npos) {
+        fields.push_back(line.substr(start, end - start));
+        start = end + 1;
+    }
+    fields.push_back(line.substr(start));
+    return fields;
+}
+
+void sensor_registry::scan_class(sensor_class cls, const char *root)
+{
+    for (auto& dir : class_entries(cls)) {
+        sensor_chip chip {};
+        chip.cls = cls;
+        chip.path = root + dir;
+        chip.name = cls == SENSOR_DRM ? dir : read_line(chip.path + "/name");
+        chip.device = resolve_device(chip.path);
+
+        if (cls == SENSOR_HWMON) {
+            for (auto& file : ls(chip.path.c_str(), nullptr, LS_FILES)) {
+                if (ends_with(file, "_input")) {
+                    chip.inputs.push_back(file);
+                } else if (ends_with(file, "_label")) {
+                    auto uscore = file.find_first_of("_");
+                    chip.labels.push_back({file.substr(0, uscore) + "_input",
+                                           read_line(chip.path + "/" + file)});
+                }
+            }
+            std::sort(chip.inputs.begin(), chip.inputs.end());
+        }
+
+#ifndef NDEBUG
+        std::cerr << "sensors: " << chip.path << ": " << chip.name << "\n";
+#endif
+        m_chips.push_back(std::move(chip));
+    }
+}
+
+void sensor_registry::scan()
+{
+    m_chips.clear();
+    scan_class(SENSOR_HWMON, sensor_roots[SENSOR_HWMON]);
+    scan_class(SENSOR_POWERCAP, sensor_roots[SENSOR_POWERCAP]);
+    scan_class(SENSOR_DRM, sensor_roots[SENSOR_DRM]);
+}
+
+/* Cache format, one tab separated record per line:
+ *   boot_id <id>
+ *   chip <class> <path> <name> <device>
+ *   label <input> <label>
+ *   input <input>
+ * label and input records belong to the chip above them. */
+bool sensor_registry::load(const std::string& file, const std::string& boot_id)
+{
+    std::ifstream in(file);
+    if (!in)
+        return false;
+
+    std::string line;
+    if (!std::getline(in, line) || line != "boot_id\t" + boot_id)
+        return false;
+
+    std::vector<sensor_chip> chips;
+    while (std::getline(in, line)) {
+        auto fields = split_fields(line);
+
+        if (fields[0] == "chip" && fields.size() == 5) {
+            sensor_chip chip {};
+            chip.cls = (sensor_class) atoi(fields[1].c_str());
+            if (chip.cls > SENSOR_DRM)
+                return false;
+            chip.path = fields[2];
+            chip.name = fields[3];
+            chip.device = fields[4];
+            chips.push_back(std::move(chip));
+        } else if (fields[0] == "label" && fields.size() == 3 && !chips.empty()) {
+            chips.back().labels.push_back({fields[1], fields[2]});
+        } else if (fields[0] == "input" && fields.size() == 2 && !chips.empty()) {
+            chips.back().inputs.push_back(fields[1]);
+        } else {
+            return false;
+        }
+    }
+
+    // drivers can still be (un)loaded after boot, the layout has to match
+    for (int cls = SENSOR_HWMON; cls <= SENSOR_DRM; cls++) {
+        size_t cached = std::count_if(chips.begin(), chips.end(),
+                                      [cls](const sensor_chip& c) { return c.cls == cls; });
+        if (cached != class_entries((sensor_class) cls).size())
+            return false;
+    }
+    // hwmonN is numbered by probe order, the same count can still be a
+    // different chip behind the same path
+    for (auto& chip : chips) {
+        if (!dir_exists(chip.path))
+            return false;
+        if (chip.cls != SENSOR_DRM && read_line(chip.path + "/name") != chip.name)
+            return false;
+    }
+
+    m_chips = std::move(chips);
+    return true;
+}
+
+void sensor_registry::save(const std::string& file, const std::string& boot_id) const
+{
+    std::ofstream out(file, std::ios::out | std::ios::trunc);
+    if (!out) {
+        std::cerr << "MANGOHUD: Could not write sensor cache " << file << std::endl;
+        return;
+    }
+
+    out << "boot_id\t" << boot_id << "\n";
+    for (auto& chip : m_chips) {
+        out << "chip\t" << chip.cls << "\t" << chip.path << "\t" << chip.name << "\t" << chip.device << "\n";
+        for (auto& label : chip.labels)
+            out << "label\t" << label.input << "\t" << label.label << "\n";
+        for (auto& input : chip.inputs)
+            out << "input\t" << input << "\n";
+    }
+}
+
+void sensor_registry::init(bool persist)
+{
+    std::lock_guard<std::mutex> lk(m_mutex);
+    if (m_inited)
+        return;
+    m_inited = true;
+
+    std::string boot_id, dir, file;
+    if (persist) {
+        boot_id = read_line("/proc/sys/kernel/random/boot_id");
+        dir = get_cache_dir();
+        if (!dir.empty()) {
+            dir += "/MangoHud";
+            file = dir + "/sensors";
+        }
+    }
+
+    if (!boot_id.empty() && !file.empty() && load(file, boot_id)) {
+#ifndef NDEBUG
+        std::cerr << "sensors: using cached index " << file << "\n";
+#endif
+        return;
+    }
+
+    scan();
+
+    if (!boot_id.empty() && !file.empty()) {
+        mkdir(get_cache_dir().c_str(), 0755);
+        mkdir(dir.c_str(), 0755);
+        save(file, boot_id);
+    }
+}
+
+const sensor_chip* sensor_registry::find(sensor_class cls, const std::string& name) const
+{
+    for (auto& chip : m_chips)
+        if (chip.cls == cls && chip.name == name)
+            return &chip;
+    return nullptr;
+}
+
+const sensor_chip* sensor_registry::find_device(sensor_class cls, const std::string& device) const
+{
+    if (device.empty())
+        return nullptr;
+
+    for (auto& chip : m_chips)
+        if (chip.cls == cls && chip.device == device)
+            return &chip;
+    return nullptr;
+}
+
+bool sensor_registry::find_input(const sensor_chip& chip, const char *type, const std::string& label, std::string& input) const
+{
+    for (auto& l : chip.labels) {
+        if (starts_with(l.input, type) && l.label == label) {
+            input = chip.path + "/" + l.input;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool sensor_registry::first_input(const sensor_chip& chip, const char *type, std::string& input) const
+{
+    for (auto& i : chip.inputs) {
+        if (starts_with(i, type)) {
+            input = chip.path + "/" + i;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,60 @@
+#pragma once
+#ifndef MANGOHUD_SENSORS_H
+#define MANGOHUD_SENSORS_H
+
+#include <string>
+#include <vector>
+#include <mutex>
+
+enum sensor_class {
+    SENSOR_HWMON,
+    SENSOR_POWERCAP,
+    SENSOR_DRM,
+};
+
+struct sensor_label {
+    std::string input;  // e.g. temp1_input
+    std::string label;  // contents of temp1_label
+};
+
+struct sensor_chip {
+    sensor_class cls;
+    std::string path;   // e.g. /sys/class/hwmon/hwmon2
+    std::string name;   // hwmon and powercap "name", cardN for drm
+    std::string device; // resolved device link, shared by a card and its hwmon
+    std::vector<sensor_label> labels;
+    std::vector<std::string> inputs; // every *_input file, sorted
+};
+
+// Index of the hwmon, powercap and drm sysfs nodes, built once instead of
+// walking sysfs again for every lookup.
+class sensor_registry
+{
+public:
+    // Scans sysfs on the first call. With persist the index is cached under
+    // $XDG_CACHE_HOME/MangoHud and reused by later launches in the same boot.
+    void init(bool persist = false);
+
+    const std::vector<sensor_chip>& chips() const { return m_chips; }
+    const sensor_chip* find(sensor_class cls, const std::string& name) const;
+    const sensor_chip* find_device(sensor_class cls, const std::string& device) const;
+
+    // Path of the <type>N_input file whose label is label
+    bool find_input(const sensor_chip& chip, const char *type, const std::string& label, std::string& input) const;
+    // Path of the first <type>N_input file of the chip
+    bool first_input(const sensor_chip& chip, const char *type, std::string& input) const;
+
+private:
+    void scan();
+    void scan_class(sensor_class cls, const char *root);
+    bool load(const std::string& file, const std::string& boot_id);
+    void save(const std::string& file, const std::string& boot_id) const;
+
+    std::mutex m_mutex;
+    bool m_inited = false;
+    std::vector<sensor_chip> m_chips;
+};
+
+extern sensor_registry sensors;
+
+#endif //MANGOHUD_SENSORS_H
@@ -96,6 +96,31 @@ static bool try_stoull(unsigned long long& val, const std::string& str)
     return false;
 }
 
+// Skips leading blanks and parses an unsigned decimal number, advancing p past it.
+// Meant for procfs/sysfs buffers where sscanf per field is too slow.
+static inline bool parse_ull(const char*& p, unsigned long long& val)
+{
+    while (*p == ' ' || *p == '\t')
+        p++;
+    if (*p < '0' || *p > '9')
+        return false;
+
+    unsigned long long v = 0;
+    while (*p >= '0' && *p <= '9')
+        v = v * 10 + (*p++ - '0');
+    val = v;
+    return true;
+}
+
+// Advances p to the start of the next line, or to the terminating NUL.
+static inline void skip_line(const char*& p)
+{
+    while (*p && *p != '\n')
+        p++;
+    if (*p == '\n')
+        p++;
+}
+
 static float parse_float(const std::string& s, std::size_t* float_len = nullptr){
     std::stringstream ss(s);
     ss.imbue(std::locale::classic());
@@ -0,0 +1,101 @@
+#include "sysfs_counters.h"
+#include <cstring>
+#ifdef __gnu_linux__
+#include "io_uring_reader.h"
+#endif
+
+static bool parse_int64(const char *p, int64_t& value)
+{
+    while (*p == ' ' || *p == '\t')
+        p++;
+
+    bool neg = (*p == '-');
+    if (neg)
+        p++;
+    if (*p < '0' || *p > '9')
+        return false;
+
+    int64_t v = 0;
+    while (*p >= '0' && *p <= '9')
+        v = v * 10 + (*p++ - '0');
+    value = neg ? -v : v;
+    return true;
+}
+
+int counter_set::add(const std::string& path, size_t capacity)
+{
+    pread_file file;
+    if (capacity < 2 || !file.open(path))
+        return -1;
+
+    size_t offset = m_buffer.size();
+    m_buffer.resize(offset + capacity);
+    m_buffer[offset] = '\0';
+    m_entries.push_back({std::move(file), offset, capacity, 0});
+    return m_entries.size() - 1;
+}
+
+bool counter_set::update()
+{
+    bool ret = true;
+    for (auto& e : m_entries) {
+        if (m_queued && e.length >= 0)
+            m_buffer[e.offset + e.length] = '\0';
+        else
+            e.length = e.file.read(&m_buffer[e.offset], e.capacity);
+        ret &= (e.length > 0);
+    }
+    m_queued = false;
+    return ret;
+}
+
+#ifdef __gnu_linux__
+void counter_set::queue(io_uring_reader& reader)
+{
+    if (!reader.available())
+        return;
+
+    for (auto& e : m_entries)
+        reader.queue(e.file.fd(), &m_buffer[e.offset], e.capacity - 1, &e.length);
+    m_queued = true;
+}
+#endif
+
+bool counter_set::get(int idx, int64_t& value) const
+{
+    if (!valid(idx) || m_entries[idx].length <= 0)
+        return false;
+    return parse_int64(&m_buffer[m_entries[idx].offset], value);
+}
+
+bool counter_set::get(int idx, const char *key, int64_t& value) const
+{
+    if (!valid(idx) || m_entries[idx].length <= 0)
+        return false;
+
+    const char *p = &m_buffer[m_entries[idx].offset];
+    size_t len = strlen(key);
+    while (*p) {
+        if (!strncmp(p, key, len))
+            return parse_int64(p + len, value);
+        p = strchr(p, '\n');
+        if (!p)
+            break;
+        p++;
+    }
+    return false;
+}
+
+size_t counter_set::length(int idx) const
+{
+    if (!valid(idx) || m_entries[idx].length <= 0)
+        return 0;
+    return m_entries[idx].length;
+}
+
+const char *counter_set::text(int idx) const
+{
+    if (!valid(idx) || m_entries[idx].length <= 0)
+        return "";
+    return &m_buffer[m_entries[idx].offset];
+}
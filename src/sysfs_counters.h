@@ -0,0 +1,53 @@
+#pragma once
+#ifndef MANGOHUD_SYSFS_COUNTERS_H
+#define MANGOHUD_SYSFS_COUNTERS_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "file_utils.h"
+
+class io_uring_reader;
+
+// A set of small procfs/sysfs files that are sampled together. Paths are
+// registered once, update() re-reads all of them with pread() into a single
+// buffer and the values are parsed from there without going through stdio.
+class counter_set
+{
+public:
+    // Returns the counter index or -1 if the file can't be opened.
+    // At most capacity - 1 bytes of the file are kept.
+    int add(const std::string& path, size_t capacity = 32);
+    bool valid(int idx) const { return idx >= 0 && (size_t)idx < m_entries.size(); }
+    size_t size() const { return m_entries.size(); }
+    bool empty() const { return m_entries.empty(); }
+
+    // Re-reads every registered file, false if any of the reads failed
+    bool update();
+    // Queues the reads of every file on reader. The next update() picks up
+    // those results and only uses pread() for reads that did not complete.
+    void queue(io_uring_reader& reader);
+
+    // First integer in the file
+    bool get(int idx, int64_t& value) const;
+    // Integer following key in "key: value" style files like /proc/self/io
+    bool get(int idx, const char *key, int64_t& value) const;
+    // Raw contents from the last update, empty string if the read failed
+    const char *text(int idx) const;
+    // Number of bytes in text(), for binary files
+    size_t length(int idx) const;
+
+private:
+    struct entry {
+        pread_file file;
+        size_t offset;
+        size_t capacity;
+        ssize_t length;
+    };
+
+    std::vector<entry> m_entries;
+    std::vector<char> m_buffer;
+    bool m_queued = false;
+};
+
+#endif //MANGOHUD_SYSFS_COUNTERS_H
@@ -0,0 +1,152 @@
+#pragma once
+#ifndef MANGOHUD_TELEMETRY_H
+#define MANGOHUD_TELEMETRY_H
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <type_traits>
+#include "gpu.h"
+#include "iostats.h"
+#include "logging.h"
+
+/* Single writer, many readers. Readers never block the writer, they retry
+ * the copy if a store happened in the middle of it. */
+template <typename T>
+class seqlock {
+   static_assert(std::is_trivially_copyable<T>::value, "seqlock needs a trivially copyable type");
+
+public:
+   void store(const T& value)
+   {
+      uint64_t seq = m_seq.load(std::memory_order_relaxed);
+      m_seq.store(seq + 1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+      memcpy(&m_value, &value, sizeof(T));
+      m_seq.store(seq + 2, std::memory_order_release);
+   }
+
+   // number of completed stores
+   uint64_t version() const
+   {
+      return m_seq.load(std::memory_order_acquire) / 2;
+   }
+
+   // Copies the value if it changed since version, which is updated
+   bool load_if_newer(T& out, uint64_t& version) const
+   {
+      uint64_t seq;
+      while (true) {
+         seq = m_seq.load(std::memory_order_acquire);
+         if (seq / 2 == version && !(seq & 1))
+            return false;
+         if (seq & 1)
+            continue;
+
+         memcpy(&out, &m_value, sizeof(T));
+         std::atomic_thread_fence(std::memory_order_acquire);
+         if (m_seq.load(std::memory_order_relaxed) == seq)
+            break;
+      }
+      version = seq / 2;
+      return true;
+   }
+
+private:
+   std::atomic<uint64_t> m_seq {0};
+   T m_value {};
+};
+
+#define TELEMETRY_MAX_CORES 256
+#define TELEMETRY_MAX_RAPL_DOMAINS 16
+
+struct telemetry_gpu {
+   unsigned index;     // GPU<index>, as gpu_list counts them
+   bool primary;
+   struct gpuInfo info;
+};
+
+struct telemetry_cpu_group {
+   char name[16];
+   char key[16];  // of its log column
+   float avg;
+   float max;     // of its busiest CPU
+};
+
+// a RAPL package or one of its subdomains
+struct telemetry_rapl_domain {
+   char name[16];  // "package-0", "core-0", "dram-1"...
+   float power;    // W
+};
+
+struct telemetry_core {
+   float percent;
+   int mhz;
+   // cpuidle, % in the deepest state and entries per second
+   float idle_deepest;
+   float idle_rate;
+};
+
+/* Everything the HUD and the logger show from the hardware sampler, taken
+ * at the end of one sampler pass. */
+struct telemetry_snapshot {
+   struct gpuInfo gpu;
+   struct gpuProcInfo gpu_proc;
+   // the GPU probe is done, gpu above is still empty before
+   bool gpu_ready;
+   // every sampled GPU, gpu above is the primary one of them
+   unsigned gpu_count;
+   struct telemetry_gpu gpus[GPU_MAX_DEVICES];
+   // NVML samples taken during the pass
+   unsigned gpu_sample_count;
+   struct gpu_sample gpu_samples[GPU_MAX_SAMPLES];
+
+   struct {
+      float percent;
+      int temp;
+      int mhz;
+      float power;      // W, to the mW with RAPL
+      uint64_t energy;  // uJ since power sampling started
+   } cpu;
+   unsigned rapl_domain_count;
+   struct telemetry_rapl_domain rapl_domains[TELEMETRY_MAX_RAPL_DOMAINS];
+   unsigned core_count;
+   struct telemetry_core cores[TELEMETRY_MAX_CORES];
+   // core_load_group, the logger keeps the averages of each row
+   unsigned cpu_group_count;
+   struct telemetry_cpu_group cpu_groups[CPU_MAX_GROUPS];
+
+   float ram_used;
+   float ram_total;
+   struct log_procmem procmem;
+   struct psi_sample psi[PSI_MAX];
+   struct iostats io;
+   struct disk_sample disk;
+   // kernel name of the device above
+   char disk_name[32];
+   struct cpuidle_sample cstates;
+   char cstate_names[CPUIDLE_MAX_STATES][16];
+
+   // what the sampler itself costs, per source in HwSampler order
+   struct telemetry_cost pass_cost;
+   unsigned cost_count;
+   struct telemetry_cost costs[SAMPLER_MAX_SOURCES];
+   // reads in the io_uring batch of the pass and the syscalls they took
+   unsigned sampler_reads;
+   unsigned sampler_syscalls;
+
+   // totals and the deltas of the last sampler pass that read them
+   struct fault_counters faults_total;
+   struct fault_counters faults;
+
+   // busiest threads of the process
+   unsigned thread_count;
+   struct top_thread threads[MAX_TOP_THREADS];
+
+   // sampled columns of the log, fps and frametime are filled in by the logger
+   logData log;
+};
+
+extern seqlock<telemetry_snapshot> telemetry;
+
+#endif //MANGOHUD_TELEMETRY_H
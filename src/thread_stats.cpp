@@ -0,0 +1,159 @@
+#include "thread_stats.h"
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <iostream>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include "string_utils.h"
+
+ThreadStats threadStats;
+thread_local ThreadSchedStat presentSchedStat;
+
+ThreadStats::~ThreadStats()
+{
+    if (m_taskDir)
+        closedir(m_taskDir);
+}
+
+// /proc/self/task/<tid>/stat is "tid (comm) state ppid ... utime stime ..."
+bool ThreadStats::ReadTask(task& t, unsigned long long& time)
+{
+    ssize_t len = t.file.read(m_buf.data(), m_buf.size());
+    if (len <= 0)
+        return false;
+
+    // comm may contain spaces and parentheses
+    const char *open = strchr(m_buf.data(), '(');
+    const char *close = strrchr(m_buf.data(), ')');
+    if (!open || !close || close < open)
+        return false;
+
+    size_t nameLen = std::min<size_t>(close - open - 1, THREAD_NAME_LEN - 1);
+    memcpy(t.name, open + 1, nameLen);
+    t.name[nameLen] = '\0';
+
+    // skip state and the 10 fields up to utime (fields 3 to 13)
+    const char *p = close + 1;
+    for (int i = 0; i < 11; i++) {
+        p = strchr(p + 1, ' ');
+        if (!p)
+            return false;
+    }
+
+    unsigned long long utime, stime;
+    if (!parse_ull(p, utime) || !parse_ull(p, stime))
+        return false;
+
+    time = utime + stime;
+    return true;
+}
+
+bool ThreadStats::Update()
+{
+    if (!m_clockTicks)
+        m_clockTicks = sysconf(_SC_CLK_TCK);
+
+    if (!m_taskDir) {
+        m_taskDir = opendir("/proc/self/task");
+        if (!m_taskDir) {
+            std::cerr << "MANGOHUD: Failed to open /proc/self/task" << std::endl;
+            return false;
+        }
+    } else {
+        rewinddir(m_taskDir);
+    }
+
+    Clock::time_point now = Clock::now();
+    double elapsed = std::chrono::duration<double>(now - m_lastUpdate).count();
+    bool first = m_lastUpdate == Clock::time_point{};
+    m_lastUpdate = now;
+
+    for (auto& t : m_tasks)
+        t.seen = false;
+
+    // one getdents() for the list, new threads get their stat file opened once
+    struct dirent *dp;
+    while ((dp = readdir(m_taskDir))) {
+        if (dp->d_name[0] < '0' || dp->d_name[0] > '9')
+            continue;
+
+        pid_t tid = atoi(dp->d_name);
+        auto it = std::lower_bound(m_tasks.begin(), m_tasks.end(), tid,
+                                   [](const task& t, pid_t tid) { return t.tid < tid; });
+        if (it == m_tasks.end() || it->tid != tid) {
+            task t {};
+            t.tid = tid;
+            t.fresh = true;
+            if (!t.file.open(std::string("/proc/self/task/") + dp->d_name + "/stat"))
+                continue;
+            it = m_tasks.insert(it, std::move(t));
+        }
+        it->seen = true;
+    }
+
+    m_tasks.erase(std::remove_if(m_tasks.begin(), m_tasks.end(),
+                                 [](const task& t) { return !t.seen; }), m_tasks.end());
+
+    m_threadData.clear();
+    for (auto& t : m_tasks) {
+        unsigned long long time;
+        if (!ReadTask(t, time))
+            continue;
+
+        // count from the first sample that sees the thread
+        float percent = 0;
+        if (!first && !t.fresh && elapsed > 0 && time >= t.lastTime)
+            percent = (time - t.lastTime) * 100.0 / (elapsed * m_clockTicks);
+        t.lastTime = time;
+        t.fresh = false;
+
+        auto data = std::find_if(m_threadData.begin(), m_threadData.end(),
+                                 [&t](const ThreadData& d) { return !strcmp(d.name, t.name); });
+        if (data == m_threadData.end()) {
+            ThreadData d {};
+            memcpy(d.name, t.name, sizeof(d.name));
+            m_threadData.push_back(d);
+            data = m_threadData.end() - 1;
+        }
+        data->count++;
+        data->percent += percent;
+    }
+
+    std::sort(m_threadData.begin(), m_threadData.end(),
+              [](const ThreadData& a, const ThreadData& b) { return a.percent > b.percent; });
+    return true;
+}
+
+// schedstat is "run_ns wait_ns timeslices"
+bool ThreadSchedStat::Sample(SchedDelta& delta)
+{
+    delta = {};
+    // gettid() wrapper only exists since glibc 2.30
+    pid_t tid = syscall(SYS_gettid);
+    bool reset = false;
+    if (tid != m_tid) {
+        m_tid = tid;
+        reset = true;
+        if (!m_file.open("/proc/self/task/" + std::to_string(tid) + "/schedstat"))
+            return false;
+    }
+
+    char buf[96];
+    if (m_file.read(buf, sizeof(buf)) <= 0)
+        return false;
+
+    unsigned long long run, wait, timeslices;
+    if (sscanf(buf, "%llu %llu %llu", &run, &wait, &timeslices) != 3)
+        return false;
+
+    if (!reset && wait >= m_wait && run >= m_run) {
+        delta.run = run - m_run;
+        delta.wait = wait - m_wait;
+        delta.timeslices = timeslices - m_timeslices;
+    }
+    m_run = run;
+    m_wait = wait;
+    m_timeslices = timeslices;
+    return true;
+}
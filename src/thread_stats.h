@@ -0,0 +1,83 @@
+#pragma once
+#ifndef MANGOHUD_THREAD_STATS_H
+#define MANGOHUD_THREAD_STATS_H
+
+#include <stdint.h>
+#include <sys/types.h>
+#include <dirent.h>
+#include <vector>
+#include "timing.hpp"
+#include "file_utils.h"
+
+// TASK_COMM_LEN
+#define THREAD_NAME_LEN 16
+
+// Threads of the process sharing a name, like a pool of workers
+typedef struct ThreadData_ {
+   char name[THREAD_NAME_LEN];
+   unsigned count;
+   float percent; // of one core
+} ThreadData;
+
+class ThreadStats
+{
+public:
+   ThreadStats() = default;
+   ~ThreadStats();
+
+   // Samples /proc/self/task, threads that appeared since the last update are
+   // picked up and the ones that exited are dropped
+   bool Update();
+
+   // Busiest thread names first
+   const std::vector<ThreadData>& GetThreadData() const {
+      return m_threadData;
+   }
+
+private:
+   struct task {
+      pid_t tid;
+      pread_file file;
+      unsigned long long lastTime; // utime + stime in clock ticks
+      char name[THREAD_NAME_LEN];
+      bool seen;
+      bool fresh;
+   };
+
+   bool ReadTask(task& t, unsigned long long& time);
+
+   DIR *m_taskDir = nullptr;
+   std::vector<task> m_tasks; // sorted by tid
+   std::vector<ThreadData> m_threadData;
+   Clock::time_point m_lastUpdate {};
+   std::vector<char> m_buf = std::vector<char>(512);
+   long m_clockTicks = 0;
+};
+
+extern ThreadStats threadStats;
+
+// Scheduler times of a thread since the previous sample, in ns
+struct SchedDelta {
+   uint64_t run;
+   uint64_t wait;      // runnable but waiting for a CPU
+   uint64_t timeslices;
+};
+
+// /proc/self/task/<tid>/schedstat of the calling thread, meant to be sampled
+// by the thread presenting frames once per frame
+class ThreadSchedStat
+{
+public:
+   // Deltas are zero on the first sample
+   bool Sample(SchedDelta& delta);
+
+private:
+   pid_t m_tid = 0;
+   pread_file m_file;
+   uint64_t m_run = 0, m_wait = 0, m_timeslices = 0;
+};
+
+// one per presenting thread, apps may present from more than one
+extern thread_local ThreadSchedStat presentSchedStat;
+
+#endif //MANGOHUD_THREAD_STATS_H
@@ -0,0 +1,80 @@
+#include "throttle.h"
+#include <cstring>
+#include <cstdio>
+#include <iostream>
+#include <set>
+#include "file_utils.h"
+#include "string_utils.h"
+
+CpuThrottle cpuThrottle;
+
+const char *throttle_reason_string(unsigned reasons, char *buf, size_t size, char sep)
+{
+    static const struct { unsigned bit; const char *name; } names[] = {
+        { THROTTLE_POWER,   "PWR" },
+        { THROTTLE_CURRENT, "CUR" },
+        { THROTTLE_THERMAL, "THM" },
+        { THROTTLE_OTHER,   "OTH" },
+    };
+
+    size_t len = 0;
+    buf[0] = '\0';
+    for (auto& n : names) {
+        if (!(reasons & n.bit))
+            continue;
+        int ret = len ? snprintf(buf + len, size - len, "%c%s", sep, n.name)
+                      : snprintf(buf, size, "%s", n.name);
+        if (ret < 0 || (size_t)ret >= size - len)
+            break;
+        len += ret;
+    }
+    return buf;
+}
+
+bool CpuThrottle::Init()
+{
+    m_inited = true;
+
+    std::set<std::string> packages;
+    const std::string root = "/sys/devices/system/cpu/";
+    for (auto& cpu : ls(root.c_str(), "cpu", LS_DIRS)) {
+        if (cpu.size() < 4 || cpu[3] < '0' || cpu[3] > '9')
+            continue;
+
+        std::string dir = root + cpu + "/thermal_throttle/";
+        m_counters.add(dir + "core_throttle_count");
+
+        // every cpu of a package has the same package count
+        std::string package = read_line(root + cpu + "/topology/physical_package_id");
+        if (packages.insert(package).second)
+            m_counters.add(dir + "package_throttle_count");
+    }
+
+    if (m_counters.empty()) {
+#ifndef NDEBUG
+        std::cerr << "MANGOHUD: No thermal_throttle counters, CPU throttling is not reported\n";
+#endif
+        return false;
+    }
+    m_last.resize(m_counters.size());
+    return true;
+}
+
+bool CpuThrottle::Update()
+{
+    if (m_counters.empty())
+        return false;
+
+    m_counters.update();
+    m_reasons = 0;
+    for (size_t i = 0; i < m_counters.size(); i++) {
+        int64_t value;
+        if (!m_counters.get(i, value))
+            continue;
+        if (!m_first && value > m_last[i])
+            m_reasons |= THROTTLE_THERMAL;
+        m_last[i] = value;
+    }
+    m_first = false;
+    return true;
+}
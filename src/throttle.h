@@ -0,0 +1,46 @@
+#pragma once
+#ifndef MANGOHUD_THROTTLE_H
+#define MANGOHUD_THROTTLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include "sysfs_counters.h"
+
+class io_uring_reader;
+
+// why clocks are being held back, as a bit mask
+enum throttle_reason {
+    THROTTLE_POWER   = (1u << 0),
+    THROTTLE_CURRENT = (1u << 1),
+    THROTTLE_THERMAL = (1u << 2),
+    // throttled, but the hardware does not say why
+    THROTTLE_OTHER   = (1u << 3),
+};
+
+// "PWR THM" like short names of the reasons joined with sep, "" when none
+const char *throttle_reason_string(unsigned reasons, char *buf, size_t size, char sep = ' ');
+
+// Counts of the thermal throttling events of the cores and packages in
+// /sys/devices/system/cpu/cpuN/thermal_throttle, reported as throttling
+// when any of them went up since the previous update
+class CpuThrottle
+{
+public:
+    bool Init();
+    bool Update();
+    void Queue(io_uring_reader& reader) { m_counters.queue(reader); }
+    bool IsInitialized() const { return m_inited; }
+    unsigned Reasons() const { return m_reasons; }
+
+private:
+    counter_set m_counters;
+    std::vector<int64_t> m_last;
+    unsigned m_reasons = 0;
+    bool m_inited = false;
+    bool m_first = true;
+};
+
+extern CpuThrottle cpuThrottle;
+
+#endif //MANGOHUD_THROTTLE_H
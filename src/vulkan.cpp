@@ -55,9 +55,12 @@
 #include "string_utils.h"
 #include "file_utils.h"
 #include "gpu.h"
+#include "gpu_backend.h"
 #include "logging.h"
 #include "cpu.h"
 #include "memory.h"
+#include "sampler.h"
+#include "sensors.h"
 #include "notify.h"
 #include "blacklist.h"
 #include "pci_ids.h"
@@ -67,7 +70,6 @@ string gpuString,wineVersion,wineProcess;
 float offset_x, offset_y, hudSpacing;
 int hudFirstRow, hudSecondRow;
 VkPhysicalDeviceDriverProperties driverProps = {};
-int32_t deviceID;
 
 /* Mapped from VkInstace/VkPhysicalDevice */
 struct instance_data {
@@ -458,6 +460,7 @@ void init_cpu_stats(overlay_params& params)
 {
 #ifdef __gnu_linux__
    auto& enabled = params.enabled;
+   sensors.init(enabled[OVERLAY_PARAM_ENABLED_sensor_cache]);
    enabled[OVERLAY_PARAM_ENABLED_cpu_stats] = cpuStats.Init()
                            && enabled[OVERLAY_PARAM_ENABLED_cpu_stats];
    enabled[OVERLAY_PARAM_ENABLED_cpu_temp] = cpuStats.GetCpuFile()
@@ -474,7 +477,7 @@ struct PCI_BUS {
    int func;
 };
 
-void init_gpu_stats(uint32_t& vendorID, overlay_params& params)
+void init_gpu_stats(uint32_t vendorID, overlay_params& params, const std::string& device_pci)
 {
    //if (!params.enabled[OVERLAY_PARAM_ENABLED_gpu_stats])
    //   return;
@@ -510,83 +513,10 @@ void init_gpu_stats(uint32_t& vendorID, overlay_params& params)
       }
    }
 
-   // NVIDIA or Intel but maybe has Optimus
-   if (vendorID == 0x8086
-      || vendorID == 0x10de) {
+   // pci_dev from the config wins over the device the app renders on. The
+   // HUD shows placeholders for the GPU until the probe is done.
+   gpus.init_async(params, pci_bus_parsed ? params.pci_dev : device_pci, vendorID);
 
-      if(checkNvidia(pci_dev))
-         vendorID = 0x10de;
-      else
-         params.enabled[OVERLAY_PARAM_ENABLED_gpu_stats] = false;
-   }
-
-#ifdef __gnu_linux__
-   if (vendorID == 0x8086 || vendorID == 0x1002
-       || gpu.find("Radeon") != std::string::npos
-       || gpu.find("AMD") != std::string::npos) {
-      string path;
-      string drm = "/sys/class/drm/";
-
-      auto dirs = ls(drm.c_str(), "card");
-      for (auto& dir : dirs) {
-         path = drm + dir;
-
-#ifndef NDEBUG
-         std::cerr << "amdgpu path check: " << path << "/device/vendor" << std::endl;
-#endif
-         string device = read_line(path + "/device/device");
-         deviceID = strtol(device.c_str(), NULL, 16);
-         string line = read_line(path + "/device/vendor");
-         trim(line);
-         if (line != "0x1002" || !file_exists(path + "/device/gpu_busy_percent"))
-            continue;
-
-         path += "/device";
-         if (pci_bus_parsed && pci_dev) {
-            string pci_device = read_symlink(path.c_str());
-#ifndef NDEBUG
-            std::cerr << "PCI device symlink: " << pci_device << "\n";
-#endif
-            if (!ends_with(pci_device, pci_dev)) {
-               std::cerr << "MANGOHUD: skipping GPU, no PCI ID match\n";
-               continue;
-            }
-         }
-
-#ifndef NDEBUG
-           std::cerr << "using amdgpu path: " << path << std::endl;
-#endif
-
-         if (!amdgpu.busy)
-            amdgpu.busy = fopen((path + "/gpu_busy_percent").c_str(), "r");
-         if (!amdgpu.vram_total)
-            amdgpu.vram_total = fopen((path + "/mem_info_vram_total").c_str(), "r");
-         if (!amdgpu.vram_used)
-            amdgpu.vram_used = fopen((path + "/mem_info_vram_used").c_str(), "r");
-
-         path += "/hwmon/";
-         string tempFolder;
-         if (find_folder(path, "hwmon", tempFolder)) {
-            if (!amdgpu.core_clock)
-               amdgpu.core_clock = fopen((path + tempFolder + "/freq1_input").c_str(), "r");
-            if (!amdgpu.memory_clock)
-               amdgpu.memory_clock = fopen((path + tempFolder + "/freq2_input").c_str(), "r");
-            if (!amdgpu.temp)
-               amdgpu.temp = fopen((path + tempFolder + "/temp1_input").c_str(), "r");
-            if (!amdgpu.power_usage)
-               amdgpu.power_usage = fopen((path + tempFolder + "/power1_average").c_str(), "r");
-
-            vendorID = 0x1002;
-            break;
-         }
-      }
-
-      // don't bother then
-      if (!amdgpu.busy && !amdgpu.temp && !amdgpu.vram_total && !amdgpu.vram_used) {
-         params.enabled[OVERLAY_PARAM_ENABLED_gpu_stats] = false;
-      }
-   }
-#endif
    if (!params.permit_upload)
       printf("MANGOHUD: Uploading is disabled (permit_upload = 0)\n");
 }
@@ -2014,6 +1944,12 @@ static VkResult overlay_CreateDevice(
 
 
    bool can_get_driver_info = instance_data->api_version < VK_API_VERSION_1_1 ? false : true;
+   // only queried, the extension does not have to be enabled for that
+   bool can_get_pci_bus_info = can_get_driver_info
+      && std::any_of(available_extensions.begin(), available_extensions.end(),
+                     [](const VkExtensionProperties& ext) {
+                        return ext.extensionName == std::string(VK_EXT_PCI_BUS_INFO_EXTENSION_NAME);
+                     });
 
    // VK_KHR_driver_properties became core in 1.2
    if (instance_data->api_version < VK_API_VERSION_1_2 && can_get_driver_info) {
@@ -2061,10 +1997,23 @@ static VkResult overlay_CreateDevice(
       instance_data->vtable.GetPhysicalDeviceProperties2(device_data->physical_device, &deviceProps);
    }
 
+   // the GPU the app renders on, for picking the one the HUD shows
+   std::string device_pci;
+   if (can_get_pci_bus_info) {
+      VkPhysicalDevicePCIBusInfoPropertiesEXT pciProps = {};
+      pciProps.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PCI_BUS_INFO_PROPERTIES_EXT;
+      VkPhysicalDeviceProperties2 deviceProps = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2, &pciProps};
+      instance_data->vtable.GetPhysicalDeviceProperties2(device_data->physical_device, &deviceProps);
+      char pci[16];
+      snprintf(pci, sizeof(pci), "%04x:%02x:%02x.%x", pciProps.pciDomain, pciProps.pciBus,
+               pciProps.pciDevice, pciProps.pciFunction);
+      device_pci = pci;
+   }
+
    if (!is_blacklisted()) {
       device_map_queues(device_data, pCreateInfo);
 
-      init_gpu_stats(device_data->properties.vendorID, instance_data->params);
+      init_gpu_stats(device_data->properties.vendorID, instance_data->params, device_pci);
       init_system_info();
    }
 
@@ -2171,10 +2120,13 @@ static void overlay_DestroyInstance(
    struct instance_data *instance_data = FIND(struct instance_data, instance);
    instance_data_map_physical_devices(instance_data, false);
    instance_data->vtable.DestroyInstance(instance, pAllocator);
-   if (!is_blacklisted())
+   if (!is_blacklisted()) {
+      // sampler holds on to this instance's params
+      hw_sampler.stop();
 #ifdef __gnu_linux__
       stop_notifier(instance_data->notifier);
 #endif
+   }
    destroy_instance_data(instance_data);
 }
 
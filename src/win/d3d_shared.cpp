@@ -13,6 +13,7 @@ void init_d3d_shared(){
         return;
      parse_overlay_config(&params, getenv("MANGOHUD_CONFIG"));
      cfg_inited = true;
+     init_gpu_stats(vendorID, params, std::string());
     //  init_cpu_stats(params);
 }
 
@@ -0,0 +1,83 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "memory.h"
+
+/* update_meminfo() against the fgets and sscanf parser it replaced, on the
+ * meminfo captured in tests/data/meminfo. memory.cpp is built with
+ * PROCMEMINFOFILE pointing there. */
+
+// the parser before the single pread one, returns memused like it
+static float legacy_update(const char *path)
+{
+  char buf[256];
+  unsigned long long memmax = 0, memfree = 0, buffers = 0, cached = 0;
+  unsigned long long shmem = 0, sreclaimable = 0, memavail = 0;
+  unsigned long long swapmax = 0, swapfree = 0, memdirty = 0;
+
+  FILE *meminfo_fp = fopen(path, "re");
+  if (!meminfo_fp)
+    return -1.f;
+
+  while (!feof(meminfo_fp)) {
+    if (fgets(buf, 255, meminfo_fp) == nullptr) { break; }
+
+    if (strncmp(buf, "MemTotal:", 9) == 0) {
+      sscanf(buf, "%*s %llu", &memmax);
+    } else if (strncmp(buf, "MemFree:", 8) == 0) {
+      sscanf(buf, "%*s %llu", &memfree);
+    } else if (strncmp(buf, "SwapTotal:", 10) == 0) {
+      sscanf(buf, "%*s %llu", &swapmax);
+    } else if (strncmp(buf, "SwapFree:", 9) == 0) {
+      sscanf(buf, "%*s %llu", &swapfree);
+    } else if (strncmp(buf, "Buffers:", 8) == 0) {
+      sscanf(buf, "%*s %llu", &buffers);
+    } else if (strncmp(buf, "Cached:", 7) == 0) {
+      sscanf(buf, "%*s %llu", &cached);
+    } else if (strncmp(buf, "Dirty:", 6) == 0) {
+      sscanf(buf, "%*s %llu", &memdirty);
+    } else if (strncmp(buf, "MemAvailable:", 13) == 0) {
+      sscanf(buf, "%*s %llu", &memavail);
+    } else if (strncmp(buf, "Shmem:", 6) == 0) {
+      sscanf(buf, "%*s %llu", &shmem);
+    } else if (strncmp(buf, "SReclaimable:", 13) == 0) {
+      sscanf(buf, "%*s %llu", &sreclaimable);
+    }
+  }
+  fclose(meminfo_fp);
+
+  unsigned long long easyfree = memfree + (cached - shmem) + buffers + sreclaimable;
+  return (float(memmax) - float(easyfree)) / (1024 * 1024);
+}
+
+template <typename F>
+static double ns_per_call(unsigned iterations, F func)
+{
+  auto start = std::chrono::steady_clock::now();
+  for (unsigned i = 0; i < iterations; i++)
+    func();
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+}
+
+int main(int argc, char **argv)
+{
+  unsigned iterations = argc > 1 ? strtoul(argv[1], nullptr, 10) : 50000;
+
+  // both have to read the same values to be comparable
+  update_meminfo();
+  float legacy_used = legacy_update(PROCMEMINFOFILE);
+  if (memmax <= 0 || std::fabs(memused - legacy_used) > 1e-6f) {
+    fprintf(stderr, "parsers disagree on " PROCMEMINFOFILE ": %f != %f GiB\n", memused, legacy_used);
+    return 1;
+  }
+
+  double legacy = ns_per_call(iterations, [] { legacy_update(PROCMEMINFOFILE); });
+  double current = ns_per_call(iterations, [] { update_meminfo(); });
+  printf("%u updates\n", iterations);
+  printf("fgets + sscanf:  %6.0f ns/update\n", legacy);
+  printf("pread + table:   %6.0f ns/update (%.1fx)\n", current, legacy / current);
+  return 0;
+}
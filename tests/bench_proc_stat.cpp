@@ -0,0 +1,100 @@
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "cpu.h"
+
+/* CPUStats::UpdateCPUData() against the ifstream and sscanf parser it
+ * replaced, on the 128 CPU /proc/stat in tests/data/proc_stat_128. cpu.cpp
+ * is built with PROCDIR pointing there. */
+
+void calculateCPUData(CPUData& cpuData,
+    unsigned long long int usertime,
+    unsigned long long int nicetime,
+    unsigned long long int systemtime,
+    unsigned long long int idletime,
+    unsigned long long int ioWait,
+    unsigned long long int irq,
+    unsigned long long int softIrq,
+    unsigned long long int steal,
+    unsigned long long int guest,
+    unsigned long long int guestnice);
+
+// the parser before the persistent fd one, minus its error messages
+static bool legacy_update(const char *path, std::vector<CPUData>& cpus, CPUData& total)
+{
+    unsigned long long int usertime, nicetime, systemtime, idletime;
+    unsigned long long int ioWait, irq, softIrq, steal, guest, guestnice;
+    int cpuid = -1;
+
+    std::string line;
+    std::ifstream file (path);
+    bool ret = false;
+
+    if (!file.is_open())
+        return false;
+
+    do {
+        if (!std::getline(file, line)) {
+            break;
+        } else if (!ret && sscanf(line.c_str(), "cpu  %16llu %16llu %16llu %16llu %16llu %16llu %16llu %16llu %16llu %16llu",
+            &usertime, &nicetime, &systemtime, &idletime, &ioWait, &irq, &softIrq, &steal, &guest, &guestnice) == 10) {
+            ret = true;
+            calculateCPUData(total, usertime, nicetime, systemtime, idletime, ioWait, irq, softIrq, steal, guest, guestnice);
+        } else if (sscanf(line.c_str(), "cpu%4d %16llu %16llu %16llu %16llu %16llu %16llu %16llu %16llu %16llu %16llu",
+            &cpuid, &usertime, &nicetime, &systemtime, &idletime, &ioWait, &irq, &softIrq, &steal, &guest, &guestnice) == 11) {
+            if (!ret || cpuid < 0 || (size_t)cpuid >= cpus.size())
+                return false;
+            calculateCPUData(cpus[cpuid], usertime, nicetime, systemtime, idletime, ioWait, irq, softIrq, steal, guest, guestnice);
+            cpuid = -1;
+        } else {
+            break;
+        }
+    } while(true);
+
+    return ret;
+}
+
+template <typename F>
+static double ns_per_call(unsigned iterations, F func)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned i = 0; i < iterations; i++)
+        func();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned iterations = argc > 1 ? std::stoul(argv[1]) : 20000;
+
+    if (!cpuStats.Init()) {
+        std::cerr << "can't read " << PROCDIR "/stat" << std::endl;
+        return 1;
+    }
+    std::vector<CPUData> cpus(cpuStats.GetCPUData().size());
+    CPUData total {};
+    if (!legacy_update(PROCDIR "/stat", cpus, total)) {
+        std::cerr << "legacy parser failed on " << PROCDIR "/stat" << std::endl;
+        return 1;
+    }
+
+    // both have to see the same counters to be comparable
+    const std::vector<CPUData>& parsed = cpuStats.GetCPUData();
+    for (size_t i = 0; i < cpus.size(); i++) {
+        if (parsed[i].totalTime != cpus[i].totalTime) {
+            std::cerr << "cpu" << i << " differs: " << parsed[i].totalTime << " != " << cpus[i].totalTime << std::endl;
+            return 1;
+        }
+    }
+
+    double legacy = ns_per_call(iterations, [&] { legacy_update(PROCDIR "/stat", cpus, total); });
+    double current = ns_per_call(iterations, [&] { cpuStats.UpdateCPUData(); });
+    printf("%zu CPUs, %u updates\n", cpus.size(), iterations);
+    printf("ifstream + sscanf: %8.0f ns/update\n", legacy);
+    printf("pread + parse_ull: %8.0f ns/update (%.1fx)\n", current, legacy / current);
+    return 0;
+}
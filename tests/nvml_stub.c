@@ -0,0 +1,137 @@
+#include <string.h>
+#include "nvml.h"
+#include "nvml_stub.h"
+
+/* Stands in for libnvidia-ml.so.1 with one device. Only the samples are
+ * real, the test feeds them through nvml_stub_add_sample(). */
+
+#define STUB_TYPES (NVML_MEMORY_CLK_SAMPLES + 1)
+
+static struct nvmlDevice_st *stub_device = (struct nvmlDevice_st *)&stub_device;
+static nvmlSample_t samples[STUB_TYPES][NVML_STUB_SAMPLES];
+static unsigned sample_count[STUB_TYPES];
+
+void nvml_stub_add_sample(nvmlSamplingType_t type, unsigned long long timestamp, unsigned value)
+{
+   nvmlSample_t *buf = samples[type];
+
+   /* a ring like the driver's, the oldest one goes */
+   if (sample_count[type] == NVML_STUB_SAMPLES) {
+      memmove(buf, buf + 1, (NVML_STUB_SAMPLES - 1) * sizeof(*buf));
+      sample_count[type]--;
+   }
+   buf[sample_count[type]].timeStamp = timestamp;
+   buf[sample_count[type]].sampleValue.uiVal = value;
+   sample_count[type]++;
+}
+
+nvmlReturn_t nvmlInit_v2(void) { return NVML_SUCCESS; }
+nvmlReturn_t nvmlShutdown(void) { return NVML_SUCCESS; }
+
+const char *nvmlErrorString(nvmlReturn_t result)
+{
+   return result == NVML_SUCCESS ? "Success" : "Stub error";
+}
+
+nvmlReturn_t nvmlDeviceGetCount_v2(unsigned int *count)
+{
+   *count = 1;
+   return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceGetHandleByIndex_v2(unsigned int index, nvmlDevice_t *device)
+{
+   if (index != 0)
+      return NVML_ERROR_INVALID_ARGUMENT;
+   *device = stub_device;
+   return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceGetHandleByPciBusId_v2(const char *pciBusId, nvmlDevice_t *device)
+{
+   (void)pciBusId;
+   *device = stub_device;
+   return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceGetPciInfo_v3(nvmlDevice_t device, nvmlPciInfo_t *pci)
+{
+   (void)device;
+   memset(pci, 0, sizeof(*pci));
+   pci->bus = 0x2b;
+   pci->pciDeviceId = NVML_STUB_PCI_ID;
+   return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceGetSamples(nvmlDevice_t device, nvmlSamplingType_t type, unsigned long long lastSeenTimeStamp,
+                                  nvmlValueType_t *sampleValType, unsigned int *sampleCount, nvmlSample_t *samplesOut)
+{
+   unsigned i, n = 0;
+
+   if (device != stub_device || type >= STUB_TYPES)
+      return NVML_ERROR_INVALID_ARGUMENT;
+
+   *sampleValType = NVML_VALUE_TYPE_UNSIGNED_INT;
+   if (!samplesOut) {
+      *sampleCount = NVML_STUB_SAMPLES;
+      return NVML_SUCCESS;
+   }
+
+   for (i = 0; i < sample_count[type] && n < *sampleCount; i++) {
+      if (samples[type][i].timeStamp > lastSeenTimeStamp)
+         samplesOut[n++] = samples[type][i];
+   }
+   *sampleCount = n;
+   return n ? NVML_SUCCESS : NVML_ERROR_NOT_FOUND;
+}
+
+/* not sampled by the test */
+nvmlReturn_t nvmlDeviceGetUtilizationRates(nvmlDevice_t device, nvmlUtilization_t *utilization)
+{
+   (void)device; (void)utilization;
+   return NVML_ERROR_NOT_SUPPORTED;
+}
+
+nvmlReturn_t nvmlDeviceGetTemperature(nvmlDevice_t device, nvmlTemperatureSensors_t sensorType, unsigned int *temp)
+{
+   (void)device; (void)sensorType; (void)temp;
+   return NVML_ERROR_NOT_SUPPORTED;
+}
+
+nvmlReturn_t nvmlDeviceGetMemoryInfo(nvmlDevice_t device, nvmlMemory_t *memory)
+{
+   (void)device; (void)memory;
+   return NVML_ERROR_NOT_SUPPORTED;
+}
+
+nvmlReturn_t nvmlDeviceGetClockInfo(nvmlDevice_t device, nvmlClockType_t type, unsigned int *clock)
+{
+   (void)device; (void)type; (void)clock;
+   return NVML_ERROR_NOT_SUPPORTED;
+}
+
+nvmlReturn_t nvmlDeviceGetPowerUsage(nvmlDevice_t device, unsigned int *power)
+{
+   (void)device; (void)power;
+   return NVML_ERROR_NOT_SUPPORTED;
+}
+
+nvmlReturn_t nvmlDeviceGetProcessUtilization(nvmlDevice_t device, nvmlProcessUtilizationSample_t *utilization,
+                                             unsigned int *processSamplesCount, unsigned long long lastSeenTimeStamp)
+{
+   (void)device; (void)utilization; (void)processSamplesCount; (void)lastSeenTimeStamp;
+   return NVML_ERROR_NOT_SUPPORTED;
+}
+
+nvmlReturn_t nvmlDeviceGetGraphicsRunningProcesses(nvmlDevice_t device, unsigned int *infoCount, nvmlProcessInfo_t *infos)
+{
+   (void)device; (void)infoCount; (void)infos;
+   return NVML_ERROR_NOT_SUPPORTED;
+}
+
+nvmlReturn_t nvmlDeviceGetCurrentClocksThrottleReasons(nvmlDevice_t device, unsigned long long *clocksThrottleReasons)
+{
+   (void)device;
+   *clocksThrottleReasons = 0;
+   return NVML_SUCCESS;
+}
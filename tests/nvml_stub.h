@@ -0,0 +1,21 @@
+#pragma once
+#ifndef MANGOHUD_NVML_STUB_H
+#define MANGOHUD_NVML_STUB_H
+
+#include "nvml.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* the size of the stub's sample buffer, per type */
+#define NVML_STUB_SAMPLES 8
+#define NVML_STUB_PCI_ID 0x268410de
+
+void nvml_stub_add_sample(nvmlSamplingType_t type, unsigned long long timestamp, unsigned value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //MANGOHUD_NVML_STUB_H
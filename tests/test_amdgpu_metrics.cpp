@@ -0,0 +1,87 @@
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include "amdgpu_metrics.h"
+#include "throttle.h"
+#include "test_utils.h"
+
+/* gpu_metrics blobs in tests/data/gpu_metrics, laid out like the kernel's
+ * structs. What the firmware does not report is left at all ones. */
+
+static std::vector<char> read_blob(const std::string& dir, const char *name)
+{
+    std::ifstream file(dir + "/" + name, std::ios::binary);
+    return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+static bool parse(const std::string& dir, const char *name, amdgpu_metrics& m)
+{
+    std::vector<char> blob = read_blob(dir, name);
+    if (blob.empty()) {
+        fprintf(stderr, "%s: can't read %s\n", name, dir.c_str());
+        failures++;
+        return false;
+    }
+    return amdgpu_parse_metrics(blob.data(), blob.size(), m);
+}
+
+int main(int argc, char **argv)
+{
+    std::string dir = argc > 1 ? argv[1] : "data/gpu_metrics";
+    amdgpu_metrics m;
+    const char *name;
+
+    name = "v1_1.bin";
+    CHECK(parse(dir, name, m));
+    CHECK(m.load == 37);
+    CHECK(m.temp == 54);
+    CHECK(m.core_clock == 1850);
+    CHECK(m.memory_clock == 875);
+    CHECK(m.power_usage == 96);
+    CHECK(!m.has_indep_throttle_status);
+    CHECK(amdgpu_throttle_reasons(m) == 0);
+
+    name = "v1_3.bin";
+    CHECK(parse(dir, name, m));
+    CHECK(m.load == 37);
+    CHECK(m.core_clock == 1850);
+    CHECK(m.has_indep_throttle_status);
+    CHECK(amdgpu_throttle_reasons(m) == THROTTLE_POWER);
+
+    // MI300 layout, not to be read as v1_3
+    name = "v1_4.bin";
+    CHECK(!parse(dir, name, m));
+
+    name = "v2_0.bin";
+    CHECK(parse(dir, name, m));
+    CHECK(m.load == 23);
+    CHECK(m.temp == 48);
+    CHECK(m.core_clock == 1600);
+    CHECK(m.memory_clock == -1);
+    CHECK(m.power_usage == 15);
+
+    name = "v2_1.bin";
+    CHECK(parse(dir, name, m));
+    CHECK(m.load == 99);
+    CHECK(m.temp == 61);
+    CHECK(m.core_clock == 1600);
+    CHECK(m.memory_clock == 800);
+    CHECK(m.power_usage == 12);
+    CHECK(!m.has_indep_throttle_status);
+
+    name = "v2_2.bin";
+    CHECK(parse(dir, name, m));
+    CHECK(m.load == 99);
+    CHECK(m.power_usage == 12);
+    CHECK(m.has_indep_throttle_status);
+    CHECK(amdgpu_throttle_reasons(m) == THROTTLE_THERMAL);
+
+    // a short read must not be parsed
+    name = "v1_3.bin (truncated)";
+    std::vector<char> blob = read_blob(dir, "v1_3.bin");
+    CHECK(!amdgpu_parse_metrics(blob.data(), 64, m));
+
+    return failures ? 1 : 0;
+}
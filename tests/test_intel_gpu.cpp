@@ -0,0 +1,88 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include "intel_gpu.h"
+#include "gpu.h"
+#include "test_utils.h"
+
+/* Files named and formatted like an i915 dGPU's sysfs in tests/data/intel.
+ * The energy counter is a scratch file so the test can move it forward. */
+
+// rewritten in place, the counter keeps its fd open
+static void write_energy(const std::string& path, unsigned long long uj)
+{
+    std::ofstream(path, std::ios::trunc) << uj << "\n";
+}
+
+int main(int argc, char **argv)
+{
+    std::string dir = argc > 1 ? argv[1] : "data/intel";
+    const char *name;
+
+    char energy[] = "/tmp/mangohud-test-energy-XXXXXX";
+    int fd = mkstemp(energy);
+    if (fd < 0) {
+        perror("mkstemp");
+        return 1;
+    }
+    close(fd);
+
+    name = "recorded";
+    {
+        intel_gpu gpu;
+        intel_gpu_files files;
+        files.freq = dir + "/card1/gt_act_freq_mhz";
+        files.temp = dir + "/hwmon3/temp1_input";
+        files.energy = dir + "/hwmon3/energy1_input";
+        CHECK(gpu.init(files));
+
+        gpuInfo info {};
+        CHECK(gpu.update(info));
+        CHECK(info.CoreClock == 2050);
+        CHECK(info.temp == 62);
+        // no previous energy sample
+        CHECK(info.powerUsage == 0);
+    }
+
+    name = "missing files";
+    {
+        intel_gpu gpu;
+        intel_gpu_files files;
+        files.freq = dir + "/card1/does_not_exist";
+        CHECK(!gpu.init(files));
+    }
+
+    name = "power";
+    {
+        intel_gpu gpu;
+        intel_gpu_files files;
+        files.energy = energy;
+        files.energy_range = 262143328850ull;
+        write_energy(energy, 1000000);
+        CHECK(gpu.init(files));
+
+        gpuInfo info {};
+        gpu.update(info);
+        // 1 J in about 50 ms, with plenty of slack for a loaded machine
+        write_energy(energy, 2000000);
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        gpu.update(info);
+        CHECK(info.powerUsage > 2 && info.powerUsage <= 20);
+
+        // wraps at energy_range
+        write_energy(energy, files.energy_range - 500000);
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        gpu.update(info);
+        write_energy(energy, 500000);
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        gpu.update(info);
+        CHECK(info.powerUsage > 2 && info.powerUsage <= 20);
+    }
+
+    unlink(energy);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,63 @@
+#include <cstdio>
+#include "gpu_backend.h"
+#include "nvidia_info.h"
+#include "overlay_params.h"
+#include "nvml_stub.h"
+#include "test_utils.h"
+
+/* getNVMLSamples() draining the stub NVML's sample buffers. The stub is
+ * linked in under the real library's soname, so the loader's dlopen of
+ * libnvidia-ml.so.1 gets it. */
+
+int main()
+{
+    overlay_params params {};
+    gpu_backend_list devices;
+    gpu_sample out[GPU_MAX_SAMPLES];
+    const char *name;
+
+    name = "probe";
+    probe_nvml(params, devices);
+    CHECK(devices.size() == 1);
+    if (devices.size() != 1)
+        return 1;
+    CHECK(devices[0]->device_id() == NVML_STUB_PCI_ID >> 16);
+    CHECK(devices[0]->pci_dev() == "0000:2b:00.0");
+    devices[0]->bind();
+    CHECK(nvmlSuccess);
+
+    name = "empty";
+    CHECK(getNVMLSamples(out, GPU_MAX_SAMPLES) == 0);
+
+    // clocks come in on their own timestamps and are carried forward
+    name = "carried forward";
+    nvml_stub_add_sample(NVML_PROCESSOR_CLK_SAMPLES, 100, 1500);
+    nvml_stub_add_sample(NVML_GPU_UTILIZATION_SAMPLES, 100, 40);
+    nvml_stub_add_sample(NVML_GPU_UTILIZATION_SAMPLES, 200, 50);
+    nvml_stub_add_sample(NVML_PROCESSOR_CLK_SAMPLES, 250, 1800);
+    nvml_stub_add_sample(NVML_MEMORY_CLK_SAMPLES, 250, 7000);
+    nvml_stub_add_sample(NVML_GPU_UTILIZATION_SAMPLES, 300, 60);
+    CHECK(getNVMLSamples(out, GPU_MAX_SAMPLES) == 3);
+    CHECK(out[0].timestamp == 100 && out[0].load == 40 && out[0].CoreClock == 1500);
+    CHECK(out[1].timestamp == 200 && out[1].load == 50 && out[1].CoreClock == 1500);
+    CHECK(out[2].timestamp == 300 && out[2].load == 60 && out[2].CoreClock == 1800);
+    CHECK(out[2].MemClock == 7000);
+
+    name = "drained";
+    CHECK(getNVMLSamples(out, GPU_MAX_SAMPLES) == 0);
+
+    name = "only new";
+    nvml_stub_add_sample(NVML_GPU_UTILIZATION_SAMPLES, 400, 70);
+    CHECK(getNVMLSamples(out, GPU_MAX_SAMPLES) == 1);
+    CHECK(out[0].timestamp == 400 && out[0].load == 70 && out[0].CoreClock == 1800);
+
+    // more than fit, the newest are kept oldest first
+    name = "newest kept";
+    for (unsigned i = 0; i < 6; i++)
+        nvml_stub_add_sample(NVML_GPU_UTILIZATION_SAMPLES, 500 + i * 100, i);
+    CHECK(getNVMLSamples(out, 4) == 4);
+    for (unsigned i = 0; i < 4; i++)
+        CHECK(out[i].timestamp == 700 + i * 100 && out[i].load == int(i + 2));
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,19 @@
+#pragma once
+#ifndef MANGOHUD_TEST_UTILS_H
+#define MANGOHUD_TEST_UTILS_H
+
+#include <cstdio>
+
+/* Checks of a test's main(), which names the case being checked in a local
+ * `name` and returns failures ? 1 : 0. */
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "%s:%d: %s: check failed: %s\n", __FILE__, __LINE__, name, #cond); \
+        failures++; \
+    } \
+} while (0)
+
+#endif //MANGOHUD_TEST_UTILS_H